@@ -37,7 +37,7 @@ namespace dae
 			const Vector3 reflect = l - (2 * std::max(Vector3::Dot(n, l), 0.f) * n);
 			const float cosAlpha = std::max(Vector3::Dot(reflect, v), 0.f);
 
-			return ks * std::powf(cosAlpha, exp);
+			return ks * std::pow(cosAlpha, exp);
 		}
 	}
 }
\ No newline at end of file
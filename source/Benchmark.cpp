@@ -0,0 +1,300 @@
+//Standard includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Project includes
+#include "CameraPath.h"
+#include "PipelineStatistics.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "RenderTarget.h"
+#include "SimdKernels.h"
+
+using namespace dae;
+
+//Renders fixed camera paths over the scenes at a few resolutions, without a window or input, and writes
+//the frame times and a per stage breakdown as JSON. Numbers of two builds compare as long as the machine does.
+namespace
+{
+	struct BenchmarkScene
+	{
+		std::string name{};
+		std::string meshPath{};
+		CameraPath cameraPath{};
+	};
+
+	struct BenchmarkResult
+	{
+		std::string sceneName{};
+		int width{};
+		int height{};
+		// milliseconds, sorted
+		std::vector<float> frameTimes{};
+		// milliseconds per frame
+		float stageTimes[size_t(ProfileStage::Count)]{};
+		// summed over all frames
+		PipelineStatistics statistics{};
+	};
+
+	struct VertexTransformResult
+	{
+		size_t nrVertices{};
+		// milliseconds, median over the runs
+		float time{};
+		// GB/s read and written
+		float bandwidth{};
+	};
+
+	// rendered before timing, the first frames touch every tile and texture for the first time
+	constexpr int NrWarmupFrames{ 10 };
+
+	constexpr int Resolutions[][2]{ { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+
+	std::vector<BenchmarkScene> CreateScenes()
+	{
+		// both meshes are placed 50 units in front of the camera, see Renderer::VehicleMeshInit.
+		// The path moves in close, then sweeps around to the side
+		CameraPath cameraPath{};
+		cameraPath.AddKeyframe({ 0.f, { 0.f, 0.f, 0.f }, 0.f, 0.f });
+		cameraPath.AddKeyframe({ 1.f, { 0.f, 3.f, 25.f }, -5.f * TO_RADIANS, 0.f });
+		cameraPath.AddKeyframe({ 2.f, { -20.f, 8.f, 35.f }, -15.f * TO_RADIANS, 50.f * TO_RADIANS });
+		cameraPath.AddKeyframe({ 3.f, { -30.f, 0.f, 50.f }, 0.f, 90.f * TO_RADIANS });
+
+		return {
+			{ "tuktuk", "Resources/tuktuk.obj", cameraPath },
+			{ "vehicle", "Resources/vehicle.obj", cameraPath }
+		};
+	}
+
+	float GetPercentile(const std::vector<float>& sortedTimes, float percentile)
+	{
+		// nearest rank
+		const size_t rank = size_t(std::ceil(percentile / 100.f * sortedTimes.size()));
+		return sortedTimes[std::clamp(rank, size_t(1), sortedTimes.size()) - 1];
+	}
+
+	void SetCamera(Renderer& renderer, const CameraPath& cameraPath, int frame, int nrFrames)
+	{
+		// same spacing as --batch, the first and last frame land on the first and last key
+		const float duration = cameraPath.GetEndTime() - cameraPath.GetStartTime();
+		const float time = cameraPath.GetStartTime() + (nrFrames > 1 ? duration * frame / (nrFrames - 1) : 0.f);
+
+		const CameraKeyframe keyframe = cameraPath.Sample(time);
+		renderer.SetCameraTransform(keyframe.origin, keyframe.pitch, keyframe.yaw);
+	}
+
+	BenchmarkResult RunBenchmark(Renderer& renderer, const BenchmarkScene& scene, int nrFrames)
+	{
+		BenchmarkResult result{};
+		result.sceneName = scene.name;
+		result.width = renderer.GetRenderTarget().GetWidth();
+		result.height = renderer.GetRenderTarget().GetHeight();
+
+		Profiler& profiler = Profiler::GetInstance();
+
+		SetCamera(renderer, scene.cameraPath, 0, nrFrames);
+		for (int frame{}; frame < NrWarmupFrames; ++frame)
+			renderer.Render();
+
+		// the profiler times every shaded pixel, frame times are taken without it
+		profiler.SetEnabled(false);
+		for (int frame{}; frame < nrFrames; ++frame)
+		{
+			SetCamera(renderer, scene.cameraPath, frame, nrFrames);
+
+			const auto start = std::chrono::steady_clock::now();
+			renderer.Render();
+			result.frameTimes.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+			result.statistics += renderer.GetStatistics();
+		}
+		std::sort(result.frameTimes.begin(), result.frameTimes.end());
+
+		// and the breakdown from a second run over the same path
+		profiler.SetEnabled(true);
+		for (int frame{}; frame < nrFrames; ++frame)
+		{
+			SetCamera(renderer, scene.cameraPath, frame, nrFrames);
+			renderer.Render();
+
+			for (size_t i{}; i < size_t(ProfileStage::Count); ++i)
+				result.stageTimes[i] += profiler.GetStageTime(ProfileStage(i)) / nrFrames;
+		}
+		profiler.SetEnabled(false);
+
+		return result;
+	}
+
+	// The vertex stage kernel on its own, over a mesh far larger than the caches
+	VertexTransformResult RunVertexTransformBenchmark()
+	{
+		constexpr size_t NrVertices{ 4 * 1024 * 1024 };
+		constexpr int NrRuns{ 20 };
+
+		VertexStream positions{};
+		positions.x.resize(NrVertices);
+		positions.y.resize(NrVertices);
+		positions.z.resize(NrVertices);
+		for (size_t i{}; i < NrVertices; ++i)
+		{
+			positions.x[i] = float(i % 1000) * 0.01f;
+			positions.y[i] = float(i % 777) * 0.02f;
+			positions.z[i] = float(i % 555) * 0.03f;
+		}
+
+		VertexStream clipPositions{};
+		clipPositions.x.resize(NrVertices);
+		clipPositions.y.resize(NrVertices);
+		clipPositions.z.resize(NrVertices);
+		clipPositions.w.resize(NrVertices);
+
+		const Matrix matrix = Matrix::CreateRotation(0.3f, 0.5f, 0.7f) * Matrix::CreateTranslation(1.f, 2.f, 3.f);
+
+		std::vector<float> times{};
+		for (int run{}; run < NrRuns; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			GetSimdKernels().transformPoints(matrix.GetData(),
+				positions.x.data(), positions.y.data(), positions.z.data(),
+				clipPositions.x.data(), clipPositions.y.data(), clipPositions.z.data(), clipPositions.w.data(), NrVertices);
+			times.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		std::sort(times.begin(), times.end());
+
+		VertexTransformResult result{};
+		result.nrVertices = NrVertices;
+		result.time = GetPercentile(times, 50.f);
+		// 3 floats in, 4 out
+		result.bandwidth = float(NrVertices * 7 * sizeof(float)) / (result.time * 1e6f);
+		return result;
+	}
+
+	void WriteResults(std::ostream& stream, const std::vector<BenchmarkResult>& results, const VertexTransformResult& vertexTransform, int nrFrames)
+	{
+		stream << "{\n\t\"frames\": " << nrFrames << ",\n\t\"simdLevel\": \"" << GetSimdLevelName(GetSimdKernels().level) << "\",\n"
+			<< "\t\"vertexTransform\": { \"vertices\": " << vertexTransform.nrVertices << ", \"median\": " << vertexTransform.time
+			<< ", \"bandwidth\": " << vertexTransform.bandwidth << " },\n\t\"results\": [";
+
+		for (size_t resultIndex{}; resultIndex < results.size(); ++resultIndex)
+		{
+			const BenchmarkResult& result = results[resultIndex];
+			const std::vector<float>& times = result.frameTimes;
+
+			float totalTime{};
+			for (float time : times)
+				totalTime += time;
+
+			stream << (resultIndex == 0 ? "\n" : ",\n")
+				<< "\t\t{\n\t\t\t\"scene\": \"" << result.sceneName << "\", \"width\": " << result.width << ", \"height\": " << result.height << ",\n"
+				<< "\t\t\t\"frameTime\": { \"mean\": " << totalTime / times.size()
+				<< ", \"median\": " << GetPercentile(times, 50.f)
+				<< ", \"p95\": " << GetPercentile(times, 95.f)
+				<< ", \"p99\": " << GetPercentile(times, 99.f)
+				<< ", \"min\": " << times.front()
+				<< ", \"max\": " << times.back() << " },\n"
+				<< "\t\t\t\"stages\": {";
+
+			// Frame is the total of the profiled run, present doesn't happen without a window
+			for (size_t i{}; i < size_t(ProfileStage::Count); ++i)
+			{
+				if (ProfileStage(i) == ProfileStage::Present)
+					continue;
+
+				stream << (i == 0 ? " \"" : ", \"") << Profiler::GetStageName(ProfileStage(i)) << "\": " << result.stageTimes[i];
+			}
+
+			const PipelineStatistics& statistics = result.statistics;
+			const double nrFramesDouble = double(times.size());
+			stream << " },\n"
+				<< "\t\t\t\"statistics\": { \"inputTriangles\": " << statistics.nrInputTriangles / nrFramesDouble
+				<< ", \"frustumCulledTriangles\": " << statistics.nrFrustumCulledTriangles / nrFramesDouble
+				<< ", \"backFaceCulledTriangles\": " << statistics.nrBackFaceCulledTriangles / nrFramesDouble
+				<< ", \"offScreenTriangles\": " << statistics.nrOffScreenTriangles / nrFramesDouble
+				<< ", \"pixelsTested\": " << statistics.nrPixelsTested / nrFramesDouble
+				<< ", \"pixelsAccepted\": " << statistics.nrPixelsAccepted / nrFramesDouble
+				<< ", \"pixelsCovered\": " << statistics.nrPixelsCovered / nrFramesDouble
+				<< ", \"depthTestsPassed\": " << statistics.nrDepthTestsPassed / nrFramesDouble
+				<< ", \"depthTestsFailed\": " << statistics.nrDepthTestsFailed / nrFramesDouble
+				<< ", \"pixelShaderInvocations\": " << statistics.nrPixelShaderInvocations / nrFramesDouble << " }\n"
+				<< "\t\t}";
+		}
+
+		stream << "\n\t]\n}\n";
+	}
+}
+
+int main(int argc, char* args[])
+{
+	//Benchmark [output.json|-] [frames] [scene]
+	const std::string outputPath = argc > 1 ? args[1] : "Rasterizer_Benchmark.json";
+	const int nrFrames = argc > 2 ? std::stoi(args[2]) : 100;
+	const std::string sceneFilter = argc > 3 ? args[3] : "";
+
+	if (nrFrames <= 0)
+	{
+		std::cerr << "Usage: Benchmark [output.json|-] [frames] [tuktuk|vehicle]" << std::endl;
+		return 1;
+	}
+
+	std::vector<BenchmarkResult> results{};
+	for (const BenchmarkScene& scene : CreateScenes())
+	{
+		if (!sceneFilter.empty() && sceneFilter != scene.name)
+			continue;
+
+		const auto pRenderer = new Renderer(Resolutions[0][0], Resolutions[0][1], scene.meshPath);
+
+		//Every frame has to be complete
+		pRenderer->WaitForLoading();
+		if (pRenderer->HasLoadingFailed())
+		{
+			std::cerr << "Couldn't load " << scene.meshPath << std::endl;
+			delete pRenderer;
+			return 1;
+		}
+
+		for (const auto& resolution : Resolutions)
+		{
+			pRenderer->Resize(resolution[0], resolution[1]);
+			results.push_back(RunBenchmark(*pRenderer, scene, nrFrames));
+
+			const BenchmarkResult& result = results.back();
+			std::cerr << scene.name << " " << result.width << "x" << result.height << ": median " << GetPercentile(result.frameTimes, 50.f)
+				<< "ms, p99 " << GetPercentile(result.frameTimes, 99.f) << "ms" << std::endl;
+		}
+
+		delete pRenderer;
+	}
+
+	if (results.empty())
+	{
+		std::cerr << "Unknown scene " << sceneFilter << std::endl;
+		return 1;
+	}
+
+	const VertexTransformResult vertexTransform = RunVertexTransformBenchmark();
+	std::cerr << "vertex transform (" << GetSimdLevelName(GetSimdKernels().level) << "): " << vertexTransform.nrVertices << " vertices in "
+		<< vertexTransform.time << "ms, " << vertexTransform.bandwidth << "GB/s" << std::endl;
+
+	if (outputPath == "-")
+	{
+		WriteResults(std::cout, results, vertexTransform, nrFrames);
+		return 0;
+	}
+
+	std::ofstream file(outputPath);
+	WriteResults(file, results, vertexTransform, nrFrames);
+	if (!file)
+	{
+		std::cerr << "Couldn't write " << outputPath << std::endl;
+		return 1;
+	}
+
+	std::cerr << "Results written to " << outputPath << std::endl;
+	return 0;
+}
@@ -35,6 +35,9 @@ namespace dae
 
 		Matrix projectionMatrix{};
 
+		// maps the near plane to depth 1 and the far plane to 0, which spreads float precision evenly over the distance
+		bool isReversedZ{ false };
+
 		void Initialize(float _fovAngle = 90.f, Vector3 _origin = {0.f,0.f,0.f}, float _aspectRatio = 1.f)
 		{
 			fovAngle = _fovAngle;
@@ -64,8 +67,9 @@ namespace dae
 			const float near{ 0.1f };
 			const float far{ 100.f };
 			
-			const float A{ far / (far - near) };
-			const float B{ -(far * near) / (far - near) };
+			// depth = A + B / z, near => 0 and far => 1, or the other way around when reversed
+			const float A{ isReversedZ ? near / (near - far) : far / (far - near) };
+			const float B{ isReversedZ ? (far * near) / (far - near) : -(far * near) / (far - near) };
 
 			projectionMatrix =
 			{
@@ -100,6 +104,27 @@ namespace dae
 //			CalculateProjectionMatrix(fov, aspectRatio); //Try to optimize this - should only be called once or when fov/aspectRatio changes
 		}
 
+		void SetReversedZ(bool _isReversedZ)
+		{
+			isReversedZ = _isReversedZ;
+
+			CalculateProjectionMatrix();
+		}
+
+		//Places the camera directly, e.g. from a recorded path; pitch and yaw in radians
+		void SetTransform(const Vector3& _origin, float pitch, float yaw)
+		{
+			origin = _origin;
+			totalPitch = pitch;
+			totalYaw = yaw;
+
+			Matrix finalRotation = Matrix::CreateRotationX(totalPitch) * Matrix::CreateRotationY(totalYaw);
+
+			forward = finalRotation.TransformVector(Vector3::UnitZ);
+
+			CalculateViewMatrix();
+		}
+
 		void SetFovOrAspectRatio(const float newFovAngle, const float newAspectRatio)
 		{
 			fovAngle = newFovAngle;
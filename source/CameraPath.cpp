@@ -0,0 +1,73 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace dae
+{
+	bool CameraPath::LoadFromFile(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return false;
+
+		m_Keyframes.clear();
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream{ line };
+
+			CameraKeyframe keyframe{};
+			float pitchDegrees{}, yawDegrees{};
+			if (!(stream >> keyframe.time))
+				continue; // empty line or comment
+
+			if (!(stream >> keyframe.origin.x >> keyframe.origin.y >> keyframe.origin.z >> pitchDegrees >> yawDegrees))
+				return false;
+
+			keyframe.pitch = pitchDegrees * TO_RADIANS;
+			keyframe.yaw = yawDegrees * TO_RADIANS;
+			m_Keyframes.push_back(keyframe);
+		}
+
+		std::stable_sort(m_Keyframes.begin(), m_Keyframes.end(),
+			[](const CameraKeyframe& a, const CameraKeyframe& b) { return a.time < b.time; });
+
+		return !m_Keyframes.empty();
+	}
+
+	void CameraPath::AddKeyframe(const CameraKeyframe& keyframe)
+	{
+		// after keys with the same time, like the stable sort in LoadFromFile
+		const auto next = std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), keyframe.time,
+			[](float t, const CameraKeyframe& other) { return t < other.time; });
+		m_Keyframes.insert(next, keyframe);
+	}
+
+	CameraKeyframe CameraPath::Sample(float time) const
+	{
+		if (m_Keyframes.empty())
+			return {};
+
+		if (time <= m_Keyframes.front().time)
+			return m_Keyframes.front();
+		if (time >= m_Keyframes.back().time)
+			return m_Keyframes.back();
+
+		// first key after time, the one before it is <= time
+		const auto next = std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), time,
+			[](float t, const CameraKeyframe& keyframe) { return t < keyframe.time; });
+		const auto previous = next - 1;
+
+		const float factor = (time - previous->time) / (next->time - previous->time);
+
+		CameraKeyframe result{};
+		result.time = time;
+		result.origin = previous->origin + (next->origin - previous->origin) * factor;
+		result.pitch = Lerpf(previous->pitch, next->pitch, factor);
+		result.yaw = Lerpf(previous->yaw, next->yaw, factor);
+		return result;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct CameraKeyframe
+	{
+		float time{};
+		Vector3 origin{};
+		float pitch{}; //radians
+		float yaw{}; //radians
+	};
+
+	//Camera keyframes loaded from a text file, one "time x y z pitch yaw" line per key (angles in degrees).
+	//Empty lines and lines starting with '#' are ignored.
+	class CameraPath final
+	{
+	public:
+		bool LoadFromFile(const std::string& path);
+		//Inserts a key, keeping them sorted by time
+		void AddKeyframe(const CameraKeyframe& keyframe);
+
+		//Linear interpolation between the surrounding keys, clamped to the first/last key
+		CameraKeyframe Sample(float time) const;
+
+		bool IsEmpty() const { return m_Keyframes.empty(); }
+		float GetStartTime() const { return m_Keyframes.empty() ? 0.f : m_Keyframes.front().time; }
+		float GetEndTime() const { return m_Keyframes.empty() ? 0.f : m_Keyframes.back().time; }
+
+	private:
+		std::vector<CameraKeyframe> m_Keyframes{};
+	};
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "Math.h"
 #include "vector"
+#include <cstdint>
+#include <string>
 
 namespace dae
 {
@@ -30,13 +32,58 @@ namespace dae
 		TriangleStrip
 	};
 
+	// Texture paths of an MTL material, empty when the material doesn't use that map
+	struct Material
+	{
+		std::string name{};
+		std::string diffuseMap{};		//map_Kd
+		std::string normalMap{};		//map_Bump, bump or norm
+		std::string glossinessMap{};	//map_Ns
+		std::string specularMap{};		//map_Ks
+	};
+
+	// Range of the index buffer that is drawn with a single material
+	struct SubMesh
+	{
+		static constexpr uint32_t NoMaterial{ UINT32_MAX };
+
+		uint32_t indexOffset{};
+		uint32_t indexCount{};
+		uint32_t materialIndex{ NoMaterial };
+	};
+
+	// Positions as a structure of arrays, so a kernel loads 8 or 16 of one component at once
+	struct VertexStream
+	{
+		std::vector<float> x{};
+		std::vector<float> y{};
+		std::vector<float> z{};
+		// empty for model space positions, those are points
+		std::vector<float> w{};
+
+		Vector4 GetPoint(size_t index) const
+		{
+			return { x[index], y[index], z[index], w[index] };
+		}
+	};
+
 	struct Mesh
 	{
 		std::vector<Vertex> vertices{};
 		std::vector<uint32_t> indices{};
 		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleStrip };
 
+		std::vector<SubMesh> subMeshes{};
+		std::vector<Material> materials{};
+
+		// copies of the vertex positions, appended together with them in MeshLoader::PollChunks.
+		// The W4 vertex stage fills it from the vertices when the sizes differ
+		VertexStream positions{};
+
+		// W4 keeps the positions of the transformed vertices in positions_out only: NDC x, y and z with
+		// the clip space w. Both are rewritten in place every frame
 		std::vector<Vertex_Out> vertices_out{};
+		VertexStream positions_out{};
 		Matrix worldMatrix{};
 	};
 }
\ No newline at end of file
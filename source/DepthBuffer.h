@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+namespace dae
+{
+	enum class DepthFormat
+	{
+		Float32,
+		Unorm24, //24 bit fixed point in the low bits of 32
+		Unorm16 //half the bandwidth of the others, enough for small depth ranges
+	};
+
+	constexpr size_t GetDepthFormatSize(DepthFormat format)
+	{
+		return format == DepthFormat::Unorm16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	//Depth test and access for a depth buffer in any DepthFormat. Depth values are in [0, 1],
+	//normally 0 is near and smaller values win. With reversed-Z 1 is near and greater values win.
+	class DepthBuffer final
+	{
+	public:
+		DepthBuffer() = default;
+		DepthBuffer(DepthFormat format, void* pData, bool isReversedZ) :
+			m_Format{ format },
+			m_pData{ pData },
+			m_IsReversedZ{ isReversedZ }
+		{
+		}
+
+		//What the buffer is cleared to
+		float GetFarDepth() const { return m_IsReversedZ ? 0.f : 1.f; }
+
+		//Stores depth when it's at least as close as the stored value
+		bool TestAndWrite(size_t index, float depth) const
+		{
+			switch (m_Format)
+			{
+			case DepthFormat::Unorm24:
+				return TestAndWrite(static_cast<uint32_t*>(m_pData)[index], static_cast<uint32_t>(Encode(m_Format, depth)));
+			case DepthFormat::Unorm16:
+				return TestAndWrite(static_cast<uint16_t*>(m_pData)[index], static_cast<uint16_t>(Encode(m_Format, depth)));
+			default:
+				return TestAndWrite(static_cast<float*>(m_pData)[index], depth);
+			}
+		}
+
+		float Read(size_t index) const
+		{
+			switch (m_Format)
+			{
+			case DepthFormat::Unorm24:
+				return static_cast<uint32_t*>(m_pData)[index] / float(Unorm24Max);
+			case DepthFormat::Unorm16:
+				return static_cast<uint16_t*>(m_pData)[index] / float(Unorm16Max);
+			default:
+				return static_cast<float*>(m_pData)[index];
+			}
+		}
+
+		//The raw bits of depth in format, e.g. to fill a buffer with
+		static uint32_t Encode(DepthFormat format, float depth)
+		{
+			switch (format)
+			{
+			case DepthFormat::Unorm24:
+				return static_cast<uint32_t>(depth * Unorm24Max + 0.5f);
+			case DepthFormat::Unorm16:
+				return static_cast<uint32_t>(depth * Unorm16Max + 0.5f);
+			default:
+			{
+				uint32_t bits{};
+				std::memcpy(&bits, &depth, sizeof(bits));
+				return bits;
+			}
+			}
+		}
+
+	private:
+		static constexpr uint32_t Unorm24Max{ (1u << 24) - 1 };
+		static constexpr uint32_t Unorm16Max{ (1u << 16) - 1 };
+
+		DepthFormat m_Format{};
+		void* m_pData{ nullptr };
+		bool m_IsReversedZ{ false };
+
+		template<typename T>
+		bool TestAndWrite(T& stored, T depth) const
+		{
+			if (m_IsReversedZ ? depth < stored : depth > stored)
+				return false;
+
+			stored = depth;
+			return true;
+		}
+	};
+}
@@ -0,0 +1,283 @@
+#include "FrameWriter.h"
+#include "RenderTarget.h"
+
+#include <SDL_surface.h>
+#include <SDL_image.h>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		// The render target is SDL_PIXELFORMAT_ARGB8888
+		uint8_t GetRed(uint32_t pixel) { return uint8_t(pixel >> 16); }
+		uint8_t GetGreen(uint32_t pixel) { return uint8_t(pixel >> 8); }
+		uint8_t GetBlue(uint32_t pixel) { return uint8_t(pixel); }
+
+		bool WriteSurface(const std::vector<uint32_t>& pixels, int width, int height, const std::string& path, bool isPng)
+		{
+			// SDL only reads from the surface, the pixels aren't modified
+			SDL_Surface* pSurface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<uint32_t*>(pixels.data()), width, height, 32,
+				width * int(sizeof(uint32_t)), SDL_PIXELFORMAT_ARGB8888);
+			if (!pSurface)
+				return false;
+
+			const int result = isPng ? IMG_SavePNG(pSurface, path.c_str()) : SDL_SaveBMP(pSurface, path.c_str());
+
+			SDL_FreeSurface(pSurface);
+			return result == 0;
+		}
+
+		bool WriteRaw(const std::vector<uint32_t>& pixels, const std::string& path)
+		{
+			std::vector<uint8_t> bytes(pixels.size() * 3);
+			for (size_t i{}; i < pixels.size(); ++i)
+			{
+				bytes[i * 3 + 0] = GetRed(pixels[i]);
+				bytes[i * 3 + 1] = GetGreen(pixels[i]);
+				bytes[i * 3 + 2] = GetBlue(pixels[i]);
+			}
+
+			std::ofstream file(path, std::ios::binary);
+			file.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+			return bool(file);
+		}
+
+		// "Quite OK Image" format, see https://qoiformat.org/qoi-specification.pdf
+		// Fast to encode and still a lot smaller than bmp/raw
+		bool WriteQOI(const std::vector<uint32_t>& pixels, int width, int height, const std::string& path)
+		{
+			constexpr uint8_t opIndex{ 0x00 };
+			constexpr uint8_t opDiff{ 0x40 };
+			constexpr uint8_t opLuma{ 0x80 };
+			constexpr uint8_t opRun{ 0xc0 };
+			constexpr uint8_t opRGB{ 0xfe };
+
+			std::vector<uint8_t> bytes{};
+			// worst case: every pixel as RGB
+			bytes.reserve(14 + pixels.size() * 4 + 8);
+
+			const auto pushUint32 = [&bytes](uint32_t value)
+			{
+				bytes.push_back(uint8_t(value >> 24));
+				bytes.push_back(uint8_t(value >> 16));
+				bytes.push_back(uint8_t(value >> 8));
+				bytes.push_back(uint8_t(value));
+			};
+
+			bytes.insert(bytes.end(), { 'q', 'o', 'i', 'f' });
+			pushUint32(uint32_t(width));
+			pushUint32(uint32_t(height));
+			bytes.push_back(3); // RGB
+			bytes.push_back(0); // sRGB with linear alpha
+
+			// alpha is always 255, kept in the index so the zero initialized entries never match
+			uint32_t seen[64]{};
+			uint8_t previousR{}, previousG{}, previousB{};
+			int run{};
+
+			for (size_t i{}; i < pixels.size(); ++i)
+			{
+				const uint8_t r = GetRed(pixels[i]);
+				const uint8_t g = GetGreen(pixels[i]);
+				const uint8_t b = GetBlue(pixels[i]);
+
+				if (r == previousR && g == previousG && b == previousB)
+				{
+					++run;
+					if (run == 62 || i + 1 == pixels.size())
+					{
+						bytes.push_back(uint8_t(opRun | (run - 1)));
+						run = 0;
+					}
+					continue;
+				}
+
+				if (run > 0)
+				{
+					bytes.push_back(uint8_t(opRun | (run - 1)));
+					run = 0;
+				}
+
+				const uint32_t rgba = (uint32_t(r) << 24) | (uint32_t(g) << 16) | (uint32_t(b) << 8) | 0xff;
+				const uint8_t hash = uint8_t((r * 3 + g * 5 + b * 7 + 255 * 11) % 64);
+				if (seen[hash] == rgba)
+				{
+					bytes.push_back(uint8_t(opIndex | hash));
+				}
+				else
+				{
+					seen[hash] = rgba;
+
+					const int dr = int8_t(r - previousR);
+					const int dg = int8_t(g - previousG);
+					const int db = int8_t(b - previousB);
+					const int drdg = dr - dg;
+					const int dbdg = db - dg;
+
+					if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					{
+						bytes.push_back(uint8_t(opDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+					}
+					else if (dg >= -32 && dg <= 31 && drdg >= -8 && drdg <= 7 && dbdg >= -8 && dbdg <= 7)
+					{
+						bytes.push_back(uint8_t(opLuma | (dg + 32)));
+						bytes.push_back(uint8_t(((drdg + 8) << 4) | (dbdg + 8)));
+					}
+					else
+					{
+						bytes.insert(bytes.end(), { opRGB, r, g, b });
+					}
+				}
+
+				previousR = r;
+				previousG = g;
+				previousB = b;
+			}
+
+			bytes.insert(bytes.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+
+			std::ofstream file(path, std::ios::binary);
+			file.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+			return bool(file);
+		}
+	}
+
+	FrameWriter::FrameWriter(size_t maxPendingFrames) :
+		m_MaxPendingFrames{ std::max(maxPendingFrames, size_t{ 1 }) }
+	{
+		m_Thread = std::thread(&FrameWriter::WriterLoop, this);
+	}
+
+	FrameWriter::~FrameWriter()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_QueueCondition.notify_all();
+
+		m_Thread.join();
+	}
+
+	bool FrameWriter::Submit(const RenderTarget& renderTarget, const std::string& path, bool waitIfFull)
+	{
+		Frame frame{};
+		frame.width = renderTarget.GetWidth();
+		frame.height = renderTarget.GetHeight();
+		frame.path = path;
+		frame.format = GetFormatFromPath(path);
+
+		std::unique_lock lock{ m_Mutex };
+		if (waitIfFull)
+			m_QueueCondition.wait(lock, [this]() { return m_PendingFrames.size() < m_MaxPendingFrames; });
+		else if (m_PendingFrames.size() >= m_MaxPendingFrames)
+			return false;
+
+		// reuse the buffer of a frame that's already written, only the first frames allocate
+		if (!m_FreeBuffers.empty())
+		{
+			frame.pixels = std::move(m_FreeBuffers.back());
+			m_FreeBuffers.pop_back();
+		}
+		lock.unlock();
+
+		const uint32_t* pPixels = renderTarget.GetColorBuffer();
+		frame.pixels.assign(pPixels, pPixels + size_t(frame.width) * frame.height);
+
+		lock.lock();
+		m_PendingFrames.push_back(std::move(frame));
+		lock.unlock();
+
+		m_QueueCondition.notify_all();
+		return true;
+	}
+
+	void FrameWriter::Flush()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_QueueCondition.wait(lock, [this]() { return m_PendingFrames.empty() && !m_IsWriting; });
+	}
+
+	size_t FrameWriter::GetNrFailedWrites() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_NrFailedWrites;
+	}
+
+	ImageFormat FrameWriter::GetFormatFromPath(const std::string& path)
+	{
+		std::string extension = std::filesystem::path{ path }.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+
+		if (extension == ".png")
+			return ImageFormat::Png;
+		if (extension == ".qoi")
+			return ImageFormat::Qoi;
+		if (extension == ".raw")
+			return ImageFormat::Raw;
+		return ImageFormat::Bmp;
+	}
+
+	const char* FrameWriter::GetExtension(ImageFormat format)
+	{
+		switch (format)
+		{
+		case ImageFormat::Png:
+			return ".png";
+		case ImageFormat::Qoi:
+			return ".qoi";
+		case ImageFormat::Raw:
+			return ".raw";
+		default:
+			return ".bmp";
+		}
+	}
+
+	void FrameWriter::WriterLoop()
+	{
+		std::unique_lock lock{ m_Mutex };
+		while (true)
+		{
+			m_QueueCondition.wait(lock, [this]() { return m_IsStopping || !m_PendingFrames.empty(); });
+
+			// write out what's queued before stopping
+			if (m_PendingFrames.empty())
+				return;
+
+			Frame frame = std::move(m_PendingFrames.front());
+			m_PendingFrames.pop_front();
+			m_IsWriting = true;
+
+			lock.unlock();
+			m_QueueCondition.notify_all();
+
+			const bool succeeded = WriteFrame(frame);
+
+			lock.lock();
+			m_IsWriting = false;
+			if (!succeeded)
+				++m_NrFailedWrites;
+			m_FreeBuffers.push_back(std::move(frame.pixels));
+			m_QueueCondition.notify_all();
+		}
+	}
+
+	bool FrameWriter::WriteFrame(const Frame& frame)
+	{
+		switch (frame.format)
+		{
+		case ImageFormat::Png:
+			return WriteSurface(frame.pixels, frame.width, frame.height, frame.path, true);
+		case ImageFormat::Qoi:
+			return WriteQOI(frame.pixels, frame.width, frame.height, frame.path);
+		case ImageFormat::Raw:
+			return WriteRaw(frame.pixels, frame.path);
+		default:
+			return WriteSurface(frame.pixels, frame.width, frame.height, frame.path, false);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class RenderTarget;
+
+	enum class ImageFormat
+	{
+		Bmp,
+		Png,
+		Qoi,
+		Raw //tightly packed 8 bit RGB rows, top to bottom, no header
+	};
+
+	//Encodes and writes frames on a background thread. Submit only copies the color buffer
+	//into a pooled buffer, so the render thread never waits on encoding or disk I/O.
+	class FrameWriter final
+	{
+	public:
+		//At most maxPendingFrames are queued, see Submit
+		explicit FrameWriter(size_t maxPendingFrames = 8);
+		~FrameWriter();
+
+		FrameWriter(const FrameWriter&) = delete;
+		FrameWriter(FrameWriter&&) noexcept = delete;
+		FrameWriter& operator=(const FrameWriter&) = delete;
+		FrameWriter& operator=(FrameWriter&&) noexcept = delete;
+
+		//The format follows the extension of path (.bmp, .png, .qoi, .raw), unknown extensions are written as bmp.
+		//When the queue is full it waits for a free slot, or drops the frame and returns false if waitIfFull is false.
+		bool Submit(const RenderTarget& renderTarget, const std::string& path, bool waitIfFull = true);
+
+		//Blocks until every submitted frame is written
+		void Flush();
+
+		size_t GetNrFailedWrites() const;
+
+		static ImageFormat GetFormatFromPath(const std::string& path);
+		static const char* GetExtension(ImageFormat format);
+
+	private:
+		struct Frame
+		{
+			std::vector<uint32_t> pixels{};
+			int width{};
+			int height{};
+			std::string path{};
+			ImageFormat format{};
+		};
+
+		const size_t m_MaxPendingFrames;
+
+		std::thread m_Thread{};
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_QueueCondition{};
+		std::deque<Frame> m_PendingFrames{};
+		std::vector<std::vector<uint32_t>> m_FreeBuffers{};
+		bool m_IsWriting{ false };
+		bool m_IsStopping{ false };
+		size_t m_NrFailedWrites{};
+
+		void WriterLoop();
+		static bool WriteFrame(const Frame& frame);
+	};
+}
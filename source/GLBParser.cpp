@@ -0,0 +1,699 @@
+#include "GLBParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint32_t GLBMagic{ 0x46546C67 };		// "glTF"
+		constexpr uint32_t GLBChunkJSON{ 0x4E4F534A };	// "JSON"
+		constexpr uint32_t GLBChunkBIN{ 0x004E4942 };	// "BIN\0"
+
+		constexpr int ComponentByte{ 5120 };
+		constexpr int ComponentUnsignedByte{ 5121 };
+		constexpr int ComponentShort{ 5122 };
+		constexpr int ComponentUnsignedShort{ 5123 };
+		constexpr int ComponentUnsignedInt{ 5125 };
+		constexpr int ComponentFloat{ 5126 };
+
+		constexpr int ModeTriangles{ 4 };
+
+		// Counts, offsets and indices are JSON numbers, they have to be whole and fit in a GLB chunk
+		bool ToSize(double number, size_t& size)
+		{
+			if (!(number >= 0 && number <= 0xFFFFFFFF) || std::floor(number) != number)
+				return false;
+
+			size = static_cast<size_t>(number);
+			return true;
+		}
+
+		// Just enough JSON for the glTF header chunk
+		struct JsonValue
+		{
+			enum class Type
+			{
+				Null,
+				Bool,
+				Number,
+				String,
+				Array,
+				Object
+			};
+
+			Type type{ Type::Null };
+			bool boolean{};
+			double number{};
+			std::string string{};
+			std::vector<JsonValue> array{};
+			std::vector<std::pair<std::string, JsonValue>> members{};
+
+			const JsonValue* Find(std::string_view key) const
+			{
+				for (const auto& [name, value] : members)
+				{
+					if (name == key)
+						return &value;
+				}
+				return nullptr;
+			}
+
+			const JsonValue* At(size_t index) const
+			{
+				return index < array.size() ? &array[index] : nullptr;
+			}
+
+			double GetNumber(std::string_view key, double defaultValue) const
+			{
+				const JsonValue* pValue = Find(key);
+				return pValue && pValue->type == Type::Number ? pValue->number : defaultValue;
+			}
+
+			//A missing key is 0, false for anything that isn't a valid size
+			bool GetSize(std::string_view key, size_t& size) const
+			{
+				const JsonValue* pValue = Find(key);
+				if (!pValue)
+				{
+					size = 0;
+					return true;
+				}
+
+				return pValue->type == Type::Number && ToSize(pValue->number, size);
+			}
+
+			const JsonValue* FindIndexed(std::string_view arrayKey, const JsonValue* pIndex) const
+			{
+				const JsonValue* pArray = Find(arrayKey);
+				size_t index{};
+				if (!pArray || !pIndex || pIndex->type != Type::Number || !ToSize(pIndex->number, index))
+					return nullptr;
+
+				return pArray->At(index);
+			}
+		};
+
+		class JsonParser final
+		{
+		public:
+			explicit JsonParser(std::string_view text) : m_Text{ text } {}
+
+			bool Parse(JsonValue& value)
+			{
+				if (!ParseValue(value, 0))
+					return false;
+
+				SkipWhitespace();
+				return m_Pos == m_Text.size();
+			}
+
+		private:
+			static constexpr int MaxDepth{ 64 };
+
+			std::string_view m_Text;
+			size_t m_Pos{};
+
+			void SkipWhitespace()
+			{
+				// GLB pads the JSON chunk with spaces
+				while (m_Pos < m_Text.size() && (m_Text[m_Pos] == ' ' || m_Text[m_Pos] == '\t' || m_Text[m_Pos] == '\n' || m_Text[m_Pos] == '\r'))
+					++m_Pos;
+			}
+
+			bool Consume(char c)
+			{
+				SkipWhitespace();
+				if (m_Pos >= m_Text.size() || m_Text[m_Pos] != c)
+					return false;
+
+				++m_Pos;
+				return true;
+			}
+
+			bool ConsumeLiteral(std::string_view literal)
+			{
+				if (m_Text.substr(m_Pos, literal.size()) != literal)
+					return false;
+
+				m_Pos += literal.size();
+				return true;
+			}
+
+			bool ParseValue(JsonValue& value, int depth)
+			{
+				if (depth > MaxDepth)
+					return false;
+
+				SkipWhitespace();
+				if (m_Pos >= m_Text.size())
+					return false;
+
+				switch (m_Text[m_Pos])
+				{
+				case '{':
+					value.type = JsonValue::Type::Object;
+					return ParseObject(value, depth);
+				case '[':
+					value.type = JsonValue::Type::Array;
+					return ParseArray(value, depth);
+				case '"':
+					value.type = JsonValue::Type::String;
+					return ParseString(value.string);
+				case 't':
+					value.type = JsonValue::Type::Bool;
+					value.boolean = true;
+					return ConsumeLiteral("true");
+				case 'f':
+					value.type = JsonValue::Type::Bool;
+					value.boolean = false;
+					return ConsumeLiteral("false");
+				case 'n':
+					value.type = JsonValue::Type::Null;
+					return ConsumeLiteral("null");
+				default:
+					value.type = JsonValue::Type::Number;
+					return ParseNumber(value.number);
+				}
+			}
+
+			bool ParseObject(JsonValue& value, int depth)
+			{
+				++m_Pos; // '{'
+				if (Consume('}'))
+					return true;
+
+				do
+				{
+					SkipWhitespace();
+
+					std::string key;
+					if (!ParseString(key) || !Consume(':'))
+						return false;
+
+					value.members.emplace_back(std::move(key), JsonValue{});
+					if (!ParseValue(value.members.back().second, depth + 1))
+						return false;
+				} while (Consume(','));
+
+				return Consume('}');
+			}
+
+			bool ParseArray(JsonValue& value, int depth)
+			{
+				++m_Pos; // '['
+				if (Consume(']'))
+					return true;
+
+				do
+				{
+					value.array.emplace_back();
+					if (!ParseValue(value.array.back(), depth + 1))
+						return false;
+				} while (Consume(','));
+
+				return Consume(']');
+			}
+
+			bool ParseString(std::string& string)
+			{
+				if (m_Pos >= m_Text.size() || m_Text[m_Pos] != '"')
+					return false;
+				++m_Pos;
+
+				while (m_Pos < m_Text.size())
+				{
+					const char c = m_Text[m_Pos++];
+					if (c == '"')
+						return true;
+
+					if (c != '\\')
+					{
+						string += c;
+						continue;
+					}
+
+					if (m_Pos >= m_Text.size())
+						return false;
+
+					switch (m_Text[m_Pos++])
+					{
+					case '"': string += '"'; break;
+					case '\\': string += '\\'; break;
+					case '/': string += '/'; break;
+					case 'b': string += '\b'; break;
+					case 'f': string += '\f'; break;
+					case 'n': string += '\n'; break;
+					case 'r': string += '\r'; break;
+					case 't': string += '\t'; break;
+					case 'u':
+					{
+						uint32_t codePoint{};
+						if (!ParseHex4(codePoint))
+							return false;
+
+						// surrogate pair
+						if (codePoint >= 0xD800 && codePoint < 0xDC00 && ConsumeLiteral("\\u"))
+						{
+							uint32_t low{};
+							if (!ParseHex4(low))
+								return false;
+							codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						}
+
+						AppendUTF8(string, codePoint);
+						break;
+					}
+					default:
+						return false;
+					}
+				}
+
+				return false;
+			}
+
+			bool ParseHex4(uint32_t& value)
+			{
+				if (m_Pos + 4 > m_Text.size())
+					return false;
+
+				const auto result = std::from_chars(m_Text.data() + m_Pos, m_Text.data() + m_Pos + 4, value, 16);
+				if (result.ptr != m_Text.data() + m_Pos + 4)
+					return false;
+
+				m_Pos += 4;
+				return true;
+			}
+
+			static void AppendUTF8(std::string& string, uint32_t codePoint)
+			{
+				if (codePoint < 0x80)
+				{
+					string += static_cast<char>(codePoint);
+				}
+				else if (codePoint < 0x800)
+				{
+					string += static_cast<char>(0xC0 | (codePoint >> 6));
+					string += static_cast<char>(0x80 | (codePoint & 0x3F));
+				}
+				else if (codePoint < 0x10000)
+				{
+					string += static_cast<char>(0xE0 | (codePoint >> 12));
+					string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+					string += static_cast<char>(0x80 | (codePoint & 0x3F));
+				}
+				else
+				{
+					string += static_cast<char>(0xF0 | (codePoint >> 18));
+					string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+					string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+					string += static_cast<char>(0x80 | (codePoint & 0x3F));
+				}
+			}
+
+			bool ParseNumber(double& number)
+			{
+				// from_chars doesn't accept the leading '+' JSON doesn't allow either
+				const char* pBegin = m_Text.data() + m_Pos;
+				const auto result = std::from_chars(pBegin, m_Text.data() + m_Text.size(), number);
+				if (result.ec != std::errc{})
+					return false;
+
+				m_Pos += result.ptr - pBegin;
+				return true;
+			}
+		};
+
+		// Where an accessor's elements live inside the binary chunk
+		struct AccessorView
+		{
+			const uint8_t* pData{};
+			size_t count{};
+			size_t stride{};
+			int componentType{};
+			int nrComponents{};
+			bool normalized{};
+		};
+
+		int ComponentSize(int componentType)
+		{
+			switch (componentType)
+			{
+			case ComponentByte: case ComponentUnsignedByte: return 1;
+			case ComponentShort: case ComponentUnsignedShort: return 2;
+			case ComponentUnsignedInt: case ComponentFloat: return 4;
+			default: return 0;
+			}
+		}
+
+		int NrComponents(const std::string& type)
+		{
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			return 0;
+		}
+
+		bool GetAccessorView(const JsonValue& root, const JsonValue* pAccessorIndex, const uint8_t* pBin, size_t binSize, AccessorView& view)
+		{
+			const JsonValue* pAccessor = root.FindIndexed("accessors", pAccessorIndex);
+			if (!pAccessor)
+				return false;
+
+			// sparse accessors and accessors without a buffer view (all zeros) aren't supported
+			const JsonValue* pBufferView = root.FindIndexed("bufferViews", pAccessor->Find("bufferView"));
+			if (!pBufferView || pAccessor->Find("sparse") || pBufferView->GetNumber("buffer", 0) != 0)
+				return false;
+
+			const JsonValue* pType = pAccessor->Find("type");
+			const JsonValue* pNormalized = pAccessor->Find("normalized");
+
+			size_t componentType{}, viewOffset{}, viewLength{}, accessorOffset{};
+			if (!pAccessor->GetSize("componentType", componentType)
+				|| !pAccessor->GetSize("count", view.count)
+				|| !pAccessor->GetSize("byteOffset", accessorOffset)
+				|| !pBufferView->GetSize("byteOffset", viewOffset)
+				|| !pBufferView->GetSize("byteLength", viewLength)
+				|| !pBufferView->GetSize("byteStride", view.stride))
+				return false;
+
+			view.componentType = static_cast<int>(componentType);
+			view.nrComponents = pType ? NrComponents(pType->string) : 0;
+			view.normalized = pNormalized && pNormalized->boolean;
+
+			const size_t elementSize = size_t(ComponentSize(view.componentType)) * view.nrComponents;
+			if (elementSize == 0)
+				return false;
+
+			if (view.stride == 0)
+				view.stride = elementSize;
+
+			// the last element has to end inside both the view and the chunk. Every size is checked against
+			// what's left, a bogus count or stride can't overflow the sum
+			if (viewOffset > binSize || viewLength > binSize - viewOffset)
+				return false;
+			if (view.count > 0 && (accessorOffset > viewLength || elementSize > viewLength - accessorOffset
+				|| view.count - 1 > (viewLength - accessorOffset - elementSize) / view.stride))
+				return false;
+
+			view.pData = pBin + viewOffset + accessorOffset;
+			return true;
+		}
+
+		float ReadComponent(const uint8_t* pData, int componentType, bool normalized)
+		{
+			switch (componentType)
+			{
+			case ComponentFloat:
+			{
+				float value;
+				std::memcpy(&value, pData, sizeof(value));
+				return value;
+			}
+			case ComponentByte:
+			{
+				const int8_t value = static_cast<int8_t>(pData[0]);
+				// the smallest value is clamped, -128 and -127 both map to -1
+				return normalized ? std::max(value / 127.f, -1.f) : value;
+			}
+			case ComponentUnsignedByte:
+				return normalized ? pData[0] / 255.f : pData[0];
+			case ComponentShort:
+			{
+				int16_t value;
+				std::memcpy(&value, pData, sizeof(value));
+				return normalized ? std::max(value / 32767.f, -1.f) : value;
+			}
+			case ComponentUnsignedShort:
+			{
+				uint16_t value;
+				std::memcpy(&value, pData, sizeof(value));
+				return normalized ? value / 65535.f : value;
+			}
+			default:
+				return 0.f;
+			}
+		}
+
+		// Optional attributes are only read when every element holds the components ReadElement copies,
+		// in a type it can convert. Unsigned ints aren't allowed for vertex attributes
+		bool IsReadableAttribute(const AccessorView& view, size_t count, int nrComponents)
+		{
+			return view.count == count && view.nrComponents >= nrComponents && view.componentType != ComponentUnsignedInt;
+		}
+
+		// Floats are copied as they are, integer components are converted one by one
+		template<typename Vector>
+		void ReadElement(const AccessorView& view, size_t index, Vector& out, int nrComponents)
+		{
+			const uint8_t* pElement = view.pData + view.stride * index;
+
+			if (view.componentType == ComponentFloat)
+			{
+				std::memcpy(&out, pElement, sizeof(float) * nrComponents);
+				return;
+			}
+
+			const int componentSize = ComponentSize(view.componentType);
+			for (int c = 0; c < nrComponents; ++c)
+				out[c] = ReadComponent(pElement + c * componentSize, view.componentType, view.normalized);
+		}
+
+		bool ReadIndices(const AccessorView& view, std::vector<uint32_t>& indices)
+		{
+			indices.resize(view.count);
+
+			switch (view.componentType)
+			{
+			case ComponentUnsignedInt:
+				// same layout as ours, one copy when tightly packed
+				if (view.stride == sizeof(uint32_t))
+				{
+					std::memcpy(indices.data(), view.pData, view.count * sizeof(uint32_t));
+					return true;
+				}
+				for (size_t i = 0; i < view.count; ++i)
+					std::memcpy(&indices[i], view.pData + view.stride * i, sizeof(uint32_t));
+				return true;
+			case ComponentUnsignedShort:
+				for (size_t i = 0; i < view.count; ++i)
+				{
+					uint16_t index;
+					std::memcpy(&index, view.pData + view.stride * i, sizeof(index));
+					indices[i] = index;
+				}
+				return true;
+			case ComponentUnsignedByte:
+				for (size_t i = 0; i < view.count; ++i)
+					indices[i] = view.pData[view.stride * i];
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		std::string GetImagePath(const JsonValue& root, const JsonValue* pTextureInfo, const std::filesystem::path& directory)
+		{
+			if (!pTextureInfo)
+				return {};
+
+			const JsonValue* pTexture = root.FindIndexed("textures", pTextureInfo->Find("index"));
+			if (!pTexture)
+				return {};
+
+			// images embedded in the binary chunk or as data uri have no path to load from
+			const JsonValue* pImage = root.FindIndexed("images", pTexture->Find("source"));
+			const JsonValue* pUri = pImage ? pImage->Find("uri") : nullptr;
+			if (!pUri || pUri->type != JsonValue::Type::String || pUri->string.rfind("data:", 0) == 0)
+				return {};
+
+			return (directory / pUri->string).lexically_normal().generic_string();
+		}
+	}
+
+	bool Utils::ParseGLB(const std::string& filename, MeshChunk& mesh, bool flipAxisAndWinding, ThreadPool* pThreadPool)
+	{
+		mesh = MeshChunk{};
+
+		// One read, after that the vertex data is used where it lies
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		if (!file)
+			return false;
+
+		std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		if (!file.read(reinterpret_cast<char*>(data.data()), data.size()))
+			return false;
+
+		const auto readUInt32 = [&data](size_t offset)
+		{
+			uint32_t value{};
+			if (offset + sizeof(value) <= data.size())
+				std::memcpy(&value, data.data() + offset, sizeof(value));
+			return value;
+		};
+
+		// header: magic, version, length
+		if (readUInt32(0) != GLBMagic || readUInt32(4) != 2)
+			return false;
+
+		std::string_view jsonText{};
+		const uint8_t* pBin{};
+		size_t binSize{};
+
+		// chunks: length, type, data (padded to 4 bytes)
+		for (size_t offset = 12; offset + 8 <= data.size();)
+		{
+			const size_t chunkLength = readUInt32(offset);
+			const uint32_t chunkType = readUInt32(offset + 4);
+			if (offset + 8 + chunkLength > data.size())
+				return false;
+
+			if (chunkType == GLBChunkJSON && jsonText.empty())
+				jsonText = { reinterpret_cast<const char*>(data.data() + offset + 8), chunkLength };
+			else if (chunkType == GLBChunkBIN && !pBin)
+			{
+				pBin = data.data() + offset + 8;
+				binSize = chunkLength;
+			}
+
+			offset += 8 + ((chunkLength + 3) & ~size_t{ 3 });
+		}
+
+		JsonValue root{};
+		if (jsonText.empty() || !JsonParser{ jsonText }.Parse(root))
+			return false;
+
+		const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+
+		// glTF materials map one to one on ours, so primitives can keep their material index
+		if (const JsonValue* pMaterials = root.Find("materials"))
+		{
+			for (const JsonValue& gltfMaterial : pMaterials->array)
+			{
+				Material material{};
+				if (const JsonValue* pName = gltfMaterial.Find("name"))
+					material.name = pName->string;
+
+				// metallic/roughness has no equivalent of our gloss and specular maps
+				const JsonValue* pPBR = gltfMaterial.Find("pbrMetallicRoughness");
+				material.diffuseMap = GetImagePath(root, pPBR ? pPBR->Find("baseColorTexture") : nullptr, directory);
+				material.normalMap = GetImagePath(root, gltfMaterial.Find("normalTexture"), directory);
+
+				mesh.newMaterials.push_back(std::move(material));
+			}
+		}
+
+		const JsonValue* pMeshes = root.Find("meshes");
+		if (!pMeshes)
+			return true;
+
+		for (const JsonValue& gltfMesh : pMeshes->array)
+		{
+			const JsonValue* pPrimitives = gltfMesh.Find("primitives");
+			if (!pPrimitives)
+				continue;
+
+			for (const JsonValue& primitive : pPrimitives->array)
+			{
+				const JsonValue* pAttributes = primitive.Find("attributes");
+				if (!pAttributes || primitive.GetNumber("mode", ModeTriangles) != ModeTriangles)
+					continue;
+
+				AccessorView positions{};
+				if (!GetAccessorView(root, pAttributes->Find("POSITION"), pBin, binSize, positions)
+					|| positions.componentType != ComponentFloat || positions.nrComponents != 3)
+					return false;
+
+				AccessorView normals{}, tangents{}, uvs{};
+				const bool hasNormals = GetAccessorView(root, pAttributes->Find("NORMAL"), pBin, binSize, normals) && IsReadableAttribute(normals, positions.count, 3);
+				const bool hasTangents = GetAccessorView(root, pAttributes->Find("TANGENT"), pBin, binSize, tangents) && IsReadableAttribute(tangents, positions.count, 3);
+				const bool hasUVs = GetAccessorView(root, pAttributes->Find("TEXCOORD_0"), pBin, binSize, uvs) && IsReadableAttribute(uvs, positions.count, 2);
+
+				// Vertex interleaves everything, so this is the one place where the layout is converted
+				std::vector<Vertex> vertices(positions.count);
+				for (size_t i = 0; i < positions.count; ++i)
+				{
+					Vertex& vertex = vertices[i];
+					ReadElement(positions, i, vertex.position, 3);
+					if (hasNormals)
+						ReadElement(normals, i, vertex.normal, 3);
+					// the w (handedness) is dropped, the bi-normal is always derived as normal x tangent
+					if (hasTangents)
+						ReadElement(tangents, i, vertex.tangent, 3);
+					if (hasUVs)
+						ReadElement(uvs, i, vertex.uv, 2);
+				}
+
+				std::vector<uint32_t> indices{};
+				if (const JsonValue* pIndices = primitive.Find("indices"))
+				{
+					AccessorView indexView{};
+					if (!GetAccessorView(root, pIndices, pBin, binSize, indexView) || !ReadIndices(indexView, indices))
+						return false;
+				}
+				else
+				{
+					indices.resize(positions.count);
+					for (size_t i = 0; i < indices.size(); ++i)
+						indices[i] = static_cast<uint32_t>(i);
+				}
+
+				indices.resize(indices.size() - indices.size() % 3);
+				for (const uint32_t index : indices)
+				{
+					if (index >= vertices.size())
+						return false;
+				}
+
+				if (!hasTangents)
+					CalculateTangents(vertices, indices, pThreadPool);
+
+				// glTF is right handed like OBJ, so the same flip applies
+				if (flipAxisAndWinding)
+				{
+					for (Vertex& v : vertices)
+					{
+						v.position.z *= -1.f;
+						v.normal.z *= -1.f;
+						v.tangent.z *= -1.f;
+					}
+
+					for (size_t i = 0; i < indices.size(); i += 3)
+						std::swap(indices[i + 1], indices[i + 2]);
+				}
+
+				const uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+				// an invalid material index draws the primitive without one
+				size_t materialIndex{};
+				const bool hasMaterial = primitive.Find("material") && primitive.GetSize("material", materialIndex) && materialIndex < mesh.newMaterials.size();
+
+				mesh.subMeshes.push_back({
+					static_cast<uint32_t>(mesh.indices.size()),
+					static_cast<uint32_t>(indices.size()),
+					hasMaterial ? static_cast<uint32_t>(materialIndex) : SubMesh::NoMaterial });
+
+				mesh.vertices.insert(mesh.vertices.end(), vertices.begin(), vertices.end());
+				if (baseVertex == 0)
+				{
+					mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+				}
+				else
+				{
+					mesh.indices.reserve(mesh.indices.size() + indices.size());
+					for (const uint32_t index : indices)
+						mesh.indices.push_back(baseVertex + index);
+				}
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+#include "Utils.h"
+
+namespace dae
+{
+	namespace Utils
+	{
+		//Parses every triangle primitive of a binary glTF 2.0 (.glb) file into one chunk: a sub mesh per
+		//primitive, materials from the images that are referenced by uri. Vertex data is read straight
+		//from the binary chunk, tangents are only generated when the file has none.
+		bool ParseGLB(const std::string& filename, MeshChunk& mesh, bool flipAxisAndWinding = true, ThreadPool* pThreadPool = nullptr);
+	}
+}
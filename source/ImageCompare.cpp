@@ -0,0 +1,49 @@
+#include "ImageCompare.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace dae
+{
+	ImageDifference CompareImages(const uint32_t* pActual, const uint32_t* pExpected, int width, int height, int tolerance, uint32_t* pDiff)
+	{
+		// small differences are hard to see otherwise
+		constexpr int DiffAmplification{ 16 };
+
+		ImageDifference result{};
+		double squaredErrorSum{};
+
+		const size_t nrPixels = size_t(width) * height;
+		for (size_t i{}; i < nrPixels; ++i)
+		{
+			int pixelDifference{};
+			for (uint32_t shift{}; shift < 24; shift += 8)
+			{
+				const int difference = std::abs(int((pActual[i] >> shift) & 0xff) - int((pExpected[i] >> shift) & 0xff));
+				pixelDifference = std::max(pixelDifference, difference);
+				squaredErrorSum += double(difference * difference);
+			}
+
+			result.maxDifference = std::max(result.maxDifference, pixelDifference);
+
+			const bool isOverTolerance = pixelDifference > tolerance;
+			if (isOverTolerance)
+				++result.nrPixelsOverTolerance;
+
+			if (pDiff)
+			{
+				const uint32_t gray = uint32_t(std::min(pixelDifference * DiffAmplification, 255));
+				pDiff[i] = isOverTolerance ? 0xffff0000 : 0xff000000 | gray << 16 | gray << 8 | gray;
+			}
+		}
+
+		const double meanSquaredError = nrPixels ? squaredErrorSum / (3.0 * double(nrPixels)) : 0.0;
+		result.psnr = meanSquaredError > 0.0
+			? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError)
+			: std::numeric_limits<double>::infinity();
+
+		return result;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	struct ImageDifference
+	{
+		int nrPixelsOverTolerance{};
+		// largest difference of a single channel
+		int maxDifference{};
+		// dB over the color channels, infinity for identical images
+		double psnr{};
+	};
+
+	//Compares two ARGB8888 images of the same size, alpha is ignored. A pixel is over the tolerance when
+	//one of its channels differs more than tolerance. pDiff (optional, same size) gets those pixels in red,
+	//the others as their largest channel difference in amplified gray
+	ImageDifference CompareImages(const uint32_t* pActual, const uint32_t* pExpected, int width, int height, int tolerance, uint32_t* pDiff = nullptr);
+}
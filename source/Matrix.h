@@ -1,60 +1,322 @@
 #pragma once
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <xmmintrin.h>
+
 #include "Vector3.h"
 #include "Vector4.h"
 
 namespace dae {
+	//Header-only so every transform in the hot loops is inlined. Outside of constant evaluation the transforms
+	//and products use SSE, which every x64 CPU has. Each lane adds up in the same order as the scalar code,
+	//so both give the same results. The wider per-CPU kernels are in SimdKernels
 	struct Matrix
 	{
-		Matrix() = default;
-		Matrix(
+		constexpr Matrix() = default;
+		constexpr Matrix(
 			const Vector3& xAxis,
 			const Vector3& yAxis,
 			const Vector3& zAxis,
-			const Vector3& t);
+			const Vector3& t) :
+			Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
+		{
+		}
 
-		Matrix(
+		constexpr Matrix(
 			const Vector4& xAxis,
 			const Vector4& yAxis,
 			const Vector4& zAxis,
-			const Vector4& t);
-
-		Matrix(const Matrix& m);
-
-		Vector3 TransformVector(const Vector3& v) const;
-		Vector3 TransformVector(float x, float y, float z) const;
-		Vector3 TransformPoint(const Vector3& p) const;
-		Vector3 TransformPoint(float x, float y, float z) const;
-
-		Vector4 TransformPoint(const Vector4& p) const;
-		Vector4 TransformPoint(float x, float y, float z, float w) const;
-
-		const Matrix& Transpose();
-		const Matrix& Inverse();
-
-		Vector3 GetAxisX() const;
-		Vector3 GetAxisY() const;
-		Vector3 GetAxisZ() const;
-		Vector3 GetTranslation() const;
-
-		static Matrix CreateTranslation(float x, float y, float z);
-		static Matrix CreateTranslation(const Vector3& t);
-		static Matrix CreateRotationX(float pitch);
-		static Matrix CreateRotationY(float yaw);
-		static Matrix CreateRotationZ(float roll);
-		static Matrix CreateRotation(float pitch, float yaw, float roll);
-		static Matrix CreateRotation(const Vector3& r);
-		static Matrix CreateScale(float sx, float sy, float sz);
-		static Matrix CreateScale(const Vector3& s);
-		static Matrix Transpose(const Matrix& m);
-		static Matrix Inverse(const Matrix& m);
-
-		static Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
-		static Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
-
-		Vector4& operator[](int index);
-		Vector4 operator[](int index) const;
-		Matrix operator*(const Matrix& m) const;
-		const Matrix& operator*=(const Matrix& m);
+			const Vector4& t) :
+			data{ xAxis, yAxis, zAxis, t }
+		{
+		}
+
+		constexpr Vector3 TransformVector(const Vector3& v) const
+		{
+			return TransformVector(v.x, v.y, v.z);
+		}
+
+		constexpr Vector3 TransformVector(float x, float y, float z) const
+		{
+			if (!std::is_constant_evaluated())
+			{
+				Vector4 result;
+				_mm_storeu_ps(&result.x, Combine(x, y, z));
+				return result;
+			}
+
+			return Vector3{
+				data[0].x * x + data[1].x * y + data[2].x * z,
+				data[0].y * x + data[1].y * y + data[2].y * z,
+				data[0].z * x + data[1].z * y + data[2].z * z
+			};
+		}
+
+		constexpr Vector3 TransformPoint(const Vector3& p) const
+		{
+			return TransformPoint(p.x, p.y, p.z);
+		}
+
+		constexpr Vector3 TransformPoint(float x, float y, float z) const
+		{
+			return TransformPoint(x, y, z, 1.f);
+		}
+
+		constexpr Vector4 TransformPoint(const Vector4& p) const
+		{
+			return TransformPoint(p.x, p.y, p.z, p.w);
+		}
+
+		//The translation is added as is, w is only there to fill the result
+		constexpr Vector4 TransformPoint(float x, float y, float z, float w) const
+		{
+			if (!std::is_constant_evaluated())
+			{
+				Vector4 result;
+				_mm_storeu_ps(&result.x, _mm_add_ps(Combine(x, y, z), _mm_loadu_ps(&data[3].x)));
+				return result;
+			}
+
+			return Vector4{
+				data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
+				data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
+				data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
+				data[0].w * x + data[1].w * y + data[2].w * z + data[3].w
+			};
+		}
+
+		//Same as TransformPoint per element, pResults may not overlap pPoints
+		void TransformPoints(const Vector3* pPoints, Vector4* pResults, size_t count) const
+		{
+			const __m128 translation = _mm_loadu_ps(&data[3].x);
+			for (size_t i{}; i < count; ++i)
+				_mm_storeu_ps(&pResults[i].x, _mm_add_ps(Combine(pPoints[i].x, pPoints[i].y, pPoints[i].z), translation));
+		}
+
+		//Same as TransformVector per element, pResults may be pVectors
+		void TransformVectors(const Vector3* pVectors, Vector3* pResults, size_t count) const
+		{
+			for (size_t i{}; i < count; ++i)
+			{
+				Vector4 result;
+				_mm_storeu_ps(&result.x, Combine(pVectors[i].x, pVectors[i].y, pVectors[i].z));
+				pResults[i] = result;
+			}
+		}
+
+		constexpr const Matrix& Transpose()
+		{
+			*this = Transpose(*this);
+			return *this;
+		}
+
+		constexpr const Matrix& Inverse()
+		{
+			//Optimized Inverse as explained in FGED1 - used widely in other libraries too.
+			const Vector3 a = data[0];
+			const Vector3 b = data[1];
+			const Vector3 c = data[2];
+			const Vector3 d = data[3];
+
+			const float x = data[0][3];
+			const float y = data[1][3];
+			const float z = data[2][3];
+			const float w = data[3][3];
+
+			Vector3 s = Vector3::Cross(a, b);
+			Vector3 t = Vector3::Cross(c, d);
+			Vector3 u = a * y - b * x;
+			Vector3 v = c * w - d * z;
+
+			float det = Vector3::Dot(s, v) + Vector3::Dot(t, u);
+			assert((det > FLT_EPSILON || det < -FLT_EPSILON) && "ERROR: determinant is 0, there is no INVERSE!");
+			float invDet = 1.f / det;
+
+			s *= invDet; t *= invDet; u *= invDet; v *= invDet;
+
+			Vector3 r0 = Vector3::Cross(b, v) + t * y;
+			Vector3 r1 = Vector3::Cross(v, a) - t * x;
+			Vector3 r2 = Vector3::Cross(d, u) + s * w;
+			Vector3 r3 = Vector3::Cross(u, c) - s * z;
+
+			data[0] = Vector4{ r0.x, r1.x, r2.x, 0.f };
+			data[1] = Vector4{ r0.y, r1.y, r2.y, 0.f };
+			data[2] = Vector4{ r0.z, r1.z, r2.z, 0.f };
+			data[3] = Vector4{ -Vector3::Dot(b, t), Vector3::Dot(a, t), -Vector3::Dot(d, s), Vector3::Dot(c, s) };
+
+			return *this;
+		}
+
+		constexpr Vector3 GetAxisX() const
+		{
+			return data[0];
+		}
+
+		constexpr Vector3 GetAxisY() const
+		{
+			return data[1];
+		}
+
+		constexpr Vector3 GetAxisZ() const
+		{
+			return data[2];
+		}
+
+		constexpr Vector3 GetTranslation() const
+		{
+			return data[3];
+		}
+
+		//16 floats, one row after the other
+		const float* GetData() const
+		{
+			return &data[0].x;
+		}
+
+		static constexpr Matrix CreateTranslation(float x, float y, float z)
+		{
+			return CreateTranslation({ x, y, z });
+		}
+
+		static constexpr Matrix CreateTranslation(const Vector3& t)
+		{
+			return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+		}
+
+		static Matrix CreateRotationX(float pitch)
+		{
+			return {
+				{1, 0, 0, 0},
+				{0, std::cos(pitch), -std::sin(pitch), 0},
+				{0, std::sin(pitch), std::cos(pitch), 0},
+				{0, 0, 0, 1}
+			};
+		}
+
+		static Matrix CreateRotationY(float yaw)
+		{
+			return {
+				{std::cos(yaw), 0, -std::sin(yaw), 0},
+				{0, 1, 0, 0},
+				{std::sin(yaw), 0, std::cos(yaw), 0},
+				{0, 0, 0, 1}
+			};
+		}
+
+		static Matrix CreateRotationZ(float roll)
+		{
+			return {
+				{std::cos(roll), std::sin(roll), 0, 0},
+				{-std::sin(roll), std::cos(roll), 0, 0},
+				{0, 0, 1, 0},
+				{0, 0, 0, 1}
+			};
+		}
+
+		static Matrix CreateRotation(float pitch, float yaw, float roll)
+		{
+			return CreateRotation({ pitch, yaw, roll });
+		}
+
+		static Matrix CreateRotation(const Vector3& r)
+		{
+			return CreateRotationX(r[0]) * CreateRotationY(r[1]) * CreateRotationZ(r[2]);
+		}
+
+		static constexpr Matrix CreateScale(float sx, float sy, float sz)
+		{
+			return { Vector3{ sx, 0, 0 }, Vector3{ 0, sy, 0 }, Vector3{ 0, 0, sz }, Vector3::Zero };
+		}
+
+		static constexpr Matrix CreateScale(const Vector3& s)
+		{
+			return CreateScale(s[0], s[1], s[2]);
+		}
+
+		static constexpr Matrix Transpose(const Matrix& m)
+		{
+			Matrix result{};
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					result[r][c] = m[c][r];
+				}
+			}
+
+			return result;
+		}
+
+		static constexpr Matrix Inverse(const Matrix& m)
+		{
+			Matrix out{ m };
+			out.Inverse();
+
+			return out;
+		}
+
+		static constexpr Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up)
+		{
+			//TODO W1
+
+			return {};
+		}
+
+		static constexpr Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf)
+		{
+			//TODO W2
+
+			return {};
+		}
+
+		#pragma region Operator Overloads
+		constexpr Vector4& operator[](int index)
+		{
+			assert(index <= 3 && index >= 0);
+			return data[index];
+		}
+
+		constexpr Vector4 operator[](int index) const
+		{
+			assert(index <= 3 && index >= 0);
+			return data[index];
+		}
+
+		//Row r of the product is row r of this matrix transforming m
+		constexpr Matrix operator*(const Matrix& m) const
+		{
+			Matrix result{};
+			if (!std::is_constant_evaluated())
+			{
+				for (int r{ 0 }; r < 4; ++r)
+				{
+					const __m128 row = m.Combine(data[r].x, data[r].y, data[r].z);
+					_mm_storeu_ps(&result.data[r].x, _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(data[r].w), _mm_loadu_ps(&m.data[3].x))));
+				}
+				return result;
+			}
+
+			const Matrix m_transposed = Transpose(m);
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					result[r][c] = Vector4::Dot(data[r], m_transposed[c]);
+				}
+			}
+
+			return result;
+		}
+
+		constexpr const Matrix& operator*=(const Matrix& m)
+		{
+			*this = *this * m;
+			return *this;
+		}
+		#pragma endregion
 
 	private:
 
@@ -71,5 +333,14 @@ namespace dae {
 		// v1x v1y v1z v1w
 		// v2x v2y v2z v2w
 		// v3x v3y v3z v3w
+
+		// x * xAxis + y * yAxis + z * zAxis, added in that order
+		__m128 Combine(float x, float y, float z) const
+		{
+			const __m128 xTerm = _mm_mul_ps(_mm_set1_ps(x), _mm_loadu_ps(&data[0].x));
+			const __m128 yTerm = _mm_mul_ps(_mm_set1_ps(y), _mm_loadu_ps(&data[1].x));
+			const __m128 zTerm = _mm_mul_ps(_mm_set1_ps(z), _mm_loadu_ps(&data[2].x));
+			return _mm_add_ps(_mm_add_ps(xTerm, yTerm), zTerm);
+		}
 	};
-}
\ No newline at end of file
+}
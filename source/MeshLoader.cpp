@@ -0,0 +1,111 @@
+#include "MeshLoader.h"
+#include "GLBParser.h"
+
+#include <filesystem>
+
+namespace dae
+{
+	MeshLoader::~MeshLoader()
+	{
+		Cancel();
+	}
+
+	void MeshLoader::LoadAsync(const std::string& path, ThreadPool* pThreadPool, size_t trianglesPerChunk, bool flipAxisAndWinding)
+	{
+		Cancel();
+
+		m_PendingChunks.clear();
+		m_IsCancelled = false;
+		m_HasFailed = false;
+		m_IsFinished = false;
+
+		m_Thread = std::thread([this, path, pThreadPool, trianglesPerChunk, flipAxisAndWinding]()
+			{
+				const auto pushChunk = [this](Utils::MeshChunk&& chunk)
+				{
+					{
+						std::lock_guard lock{ m_ChunkMutex };
+						m_PendingChunks.push_back(std::move(chunk));
+					}
+					return !m_IsCancelled;
+				};
+
+				bool succeeded{};
+				if (std::filesystem::path(path).extension() == ".glb")
+				{
+					// binary data has no parse cost worth streaming, it arrives as a single chunk
+					Utils::MeshChunk chunk{};
+					succeeded = Utils::ParseGLB(path, chunk, flipAxisAndWinding, pThreadPool);
+					if (succeeded)
+						pushChunk(std::move(chunk));
+				}
+				else
+				{
+					succeeded = Utils::ParseOBJChunked(path, trianglesPerChunk, pushChunk, flipAxisAndWinding, pThreadPool);
+				}
+
+				m_HasFailed = !succeeded;
+				m_IsFinished = true;
+			});
+	}
+
+	bool MeshLoader::PollChunks(Mesh& mesh)
+	{
+		std::vector<Utils::MeshChunk> chunks{};
+		{
+			std::lock_guard lock{ m_ChunkMutex };
+			chunks.swap(m_PendingChunks);
+		}
+
+		for (const Utils::MeshChunk& chunk : chunks)
+		{
+			mesh.materials.insert(mesh.materials.end(), chunk.newMaterials.begin(), chunk.newMaterials.end());
+
+			// chunk indices are relative to the chunk, offset them past the vertices we already have
+			const uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+			const uint32_t baseIndex = static_cast<uint32_t>(mesh.indices.size());
+
+			mesh.vertices.insert(mesh.vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+			for (const Vertex& vertex : chunk.vertices)
+			{
+				mesh.positions.x.push_back(vertex.position.x);
+				mesh.positions.y.push_back(vertex.position.y);
+				mesh.positions.z.push_back(vertex.position.z);
+			}
+
+			mesh.indices.reserve(mesh.indices.size() + chunk.indices.size());
+			for (const uint32_t index : chunk.indices)
+				mesh.indices.push_back(baseVertex + index);
+
+			for (const SubMesh& subMesh : chunk.subMeshes)
+			{
+				// a material that continues over the chunk border stays one sub mesh
+				if (!mesh.subMeshes.empty()
+					&& mesh.subMeshes.back().materialIndex == subMesh.materialIndex
+					&& mesh.subMeshes.back().indexOffset + mesh.subMeshes.back().indexCount == baseIndex + subMesh.indexOffset)
+				{
+					mesh.subMeshes.back().indexCount += subMesh.indexCount;
+					continue;
+				}
+
+				mesh.subMeshes.push_back({ baseIndex + subMesh.indexOffset, subMesh.indexCount, subMesh.materialIndex });
+			}
+		}
+
+		return !chunks.empty();
+	}
+
+	void MeshLoader::WaitUntilFinished()
+	{
+		if (m_Thread.joinable())
+			m_Thread.join();
+	}
+
+	void MeshLoader::Cancel()
+	{
+		m_IsCancelled = true;
+
+		if (m_Thread.joinable())
+			m_Thread.join();
+	}
+}
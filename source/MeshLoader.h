@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DataTypes.h"
+#include "Utils.h"
+
+namespace dae
+{
+	//Parses a mesh on a background thread and hands it over in chunks,
+	//so the render loop can already show the part that is loaded.
+	class MeshLoader final
+	{
+	public:
+		MeshLoader() = default;
+		~MeshLoader();
+
+		MeshLoader(const MeshLoader&) = delete;
+		MeshLoader(MeshLoader&&) noexcept = delete;
+		MeshLoader& operator=(const MeshLoader&) = delete;
+		MeshLoader& operator=(MeshLoader&&) noexcept = delete;
+
+		//Loads .obj files in chunks, .glb files in one go.
+		//The pool, if any, is used to spread the tangent generation of every chunk
+		void LoadAsync(const std::string& path, ThreadPool* pThreadPool = nullptr, size_t trianglesPerChunk = 2048, bool flipAxisAndWinding = true);
+
+		//Appends every chunk (vertices, indices, sub meshes and materials) that finished loading since
+		//the last call, returns true if the mesh changed
+		bool PollChunks(Mesh& mesh);
+
+		//Blocks until the background thread is done, the chunks still have to be polled
+		void WaitUntilFinished();
+
+		bool IsLoading() const { return !m_IsFinished; }
+		bool HasFailed() const { return m_HasFailed; }
+
+	private:
+		std::thread m_Thread{};
+
+		std::mutex m_ChunkMutex{};
+		std::vector<Utils::MeshChunk> m_PendingChunks{};
+
+		std::atomic<bool> m_IsFinished{ true };
+		std::atomic<bool> m_HasFailed{ false };
+		std::atomic<bool> m_IsCancelled{ false };
+
+		void Cancel();
+	};
+}
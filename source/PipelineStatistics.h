@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	//What went through the triangle list pipeline during one frame. Every call of the rasterizer counts
+	//into a copy of its own and adds it to the frame once it's done, threads never share counters
+	struct PipelineStatistics
+	{
+		uint64_t nrInputTriangles{};
+		// entirely outside one plane, behind the camera or beyond the guard band
+		uint64_t nrFrustumCulledTriangles{};
+		uint64_t nrBackFaceCulledTriangles{};
+		// the bounding box holds no sample point on screen: the triangle falls between the sample points
+		// or only overlaps the frustum outside the screen
+		uint64_t nrOffScreenTriangles{};
+
+		// pixels that went through the edge test one by one: every pixel of the bounding boxes, or of the
+		// blocks that are neither rejected nor accepted as a whole
+		uint64_t nrPixelsTested{};
+		// pixels of the blocks that lie inside all three edges, covered without being tested
+		uint64_t nrPixelsAccepted{};
+		// inside all three edges, the accepted pixels included
+		uint64_t nrPixelsCovered{};
+		uint64_t nrDepthTestsPassed{};
+		uint64_t nrDepthTestsFailed{};
+		uint64_t nrPixelShaderInvocations{};
+
+		PipelineStatistics& operator+=(const PipelineStatistics& other)
+		{
+			nrInputTriangles += other.nrInputTriangles;
+			nrFrustumCulledTriangles += other.nrFrustumCulledTriangles;
+			nrBackFaceCulledTriangles += other.nrBackFaceCulledTriangles;
+			nrOffScreenTriangles += other.nrOffScreenTriangles;
+			nrPixelsTested += other.nrPixelsTested;
+			nrPixelsAccepted += other.nrPixelsAccepted;
+			nrPixelsCovered += other.nrPixelsCovered;
+			nrDepthTestsPassed += other.nrDepthTestsPassed;
+			nrDepthTestsFailed += other.nrDepthTestsFailed;
+			nrPixelShaderInvocations += other.nrPixelShaderInvocations;
+			return *this;
+		}
+
+		//Share of the tested pixels that were inside the triangle, the accepted blocks left out
+		float GetCoverageRatio() const { return nrPixelsTested ? float(nrPixelsCovered - nrPixelsAccepted) / float(nrPixelsTested) : 0.f; }
+	};
+}
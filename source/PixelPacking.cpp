@@ -0,0 +1,23 @@
+#include "PixelPacking.h"
+
+#include "SimdKernels.h"
+
+#include <SDL_pixels.h>
+
+namespace dae
+{
+	PixelLayout PixelLayout::FromFormat(const SDL_PixelFormat* pFormat)
+	{
+		PixelLayout layout{};
+		layout.redShift = pFormat->Rshift;
+		layout.greenShift = pFormat->Gshift;
+		layout.blueShift = pFormat->Bshift;
+		layout.alphaMask = pFormat->Amask;
+		return layout;
+	}
+
+	void PackColors(const ColorRGB* pColors, uint32_t* pPixels, size_t count, const PixelLayout& layout)
+	{
+		GetSimdKernels().packColors(pColors, pPixels, count, layout);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+#include "ColorRGB.h"
+
+struct SDL_PixelFormat;
+
+namespace dae
+{
+	//Where the channels of a 32 bit pixel live, read once from the SDL format
+	//so pixels can be packed with plain shifts instead of SDL_MapRGB
+	struct PixelLayout
+	{
+		uint32_t redShift{ 16 };
+		uint32_t greenShift{ 8 };
+		uint32_t blueShift{ 0 };
+		uint32_t alphaMask{ 0xff000000 };
+
+		static PixelLayout FromFormat(const SDL_PixelFormat* pFormat);
+	};
+
+	//Channels have to be in [0, 1], see ColorRGB::MaxToOne
+	inline uint32_t PackColor(const ColorRGB& color, const PixelLayout& layout)
+	{
+		return (static_cast<uint32_t>(color.r * 255) << layout.redShift)
+			| (static_cast<uint32_t>(color.g * 255) << layout.greenShift)
+			| (static_cast<uint32_t>(color.b * 255) << layout.blueShift)
+			| layout.alphaMask;
+	}
+
+	//Packs a whole span of colors, 4, 8 or 16 at a time depending on the CPU, see SimdKernels.h.
+	//Applies MaxToOne to every color first, so the result matches MaxToOne + PackColor per pixel
+	void PackColors(const ColorRGB* pColors, uint32_t* pPixels, size_t count, const PixelLayout& layout);
+}
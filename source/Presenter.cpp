@@ -0,0 +1,100 @@
+#include "Presenter.h"
+#include "Profiler.h"
+#include "RenderTarget.h"
+
+#include <SDL_surface.h>
+#include <SDL_video.h>
+
+namespace dae
+{
+	Presenter::Presenter(SDL_Window* pWindow) :
+		m_pWindow{ pWindow }
+	{
+		m_Thread = std::thread(&Presenter::PresentLoop, this);
+	}
+
+	Presenter::~Presenter()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_Condition.notify_all();
+
+		m_Thread.join();
+	}
+
+	void Presenter::Submit(const RenderTarget* pRenderTarget)
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			// the frame that's still waiting is outdated, it's released without being shown
+			m_pQueuedTarget = pRenderTarget;
+		}
+		m_Condition.notify_all();
+	}
+
+	void Presenter::WaitUntilReleased(const RenderTarget* pRenderTarget)
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this, pRenderTarget]()
+			{
+				return m_pQueuedTarget != pRenderTarget && m_pPresentingTarget != pRenderTarget;
+			});
+	}
+
+	void Presenter::Pause()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this]() { return !m_pQueuedTarget && !m_pPresentingTarget; });
+		m_IsPaused = true;
+	}
+
+	void Presenter::Resume()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsPaused = false;
+		}
+		m_Condition.notify_all();
+	}
+
+	void Presenter::PresentLoop()
+	{
+		Profiler::GetInstance().SetThreadName("Present");
+
+		std::unique_lock lock{ m_Mutex };
+		while (true)
+		{
+			m_Condition.wait(lock, [this]() { return m_IsStopping || (m_pQueuedTarget && !m_IsPaused); });
+
+			if (!m_pQueuedTarget || m_IsPaused)
+				return;
+
+			m_pPresentingTarget = m_pQueuedTarget;
+			m_pQueuedTarget = nullptr;
+			lock.unlock();
+
+			// the main thread pumps events only while paused, so the surface stays valid until the update
+			SDL_Surface* pFrontBuffer = SDL_GetWindowSurface(m_pWindow);
+			SDL_Surface* pBackBuffer = m_pPresentingTarget->GetSurface();
+
+			if (pFrontBuffer)
+			{
+				ProfileScope presentScope{ ProfileStage::Present };
+
+				// dynamic resolution renders smaller than the window, SDL's nearest neighbour stretch upscales
+				if (pBackBuffer->w == pFrontBuffer->w && pBackBuffer->h == pFrontBuffer->h)
+					SDL_BlitSurface(pBackBuffer, nullptr, pFrontBuffer, nullptr);
+				else
+					SDL_BlitScaled(pBackBuffer, nullptr, pFrontBuffer, nullptr);
+
+				SDL_UpdateWindowSurface(m_pWindow);
+			}
+
+			lock.lock();
+			m_pPresentingTarget = nullptr;
+			m_Condition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct SDL_Window;
+
+namespace dae
+{
+	class RenderTarget;
+
+	//Copies finished frames to the window on its own thread, so rendering the next frame
+	//overlaps with the blit and the window update. Only the newest submitted frame is shown,
+	//a frame that's replaced before the present thread picks it up is skipped. Frames smaller
+	//than the window are stretched to fit.
+	//SDL only allows the window surface to be used by one thread at a time, and pumping events
+	//on the main thread can free it. The main thread pauses the presenter around that.
+	class Presenter final
+	{
+	public:
+		explicit Presenter(SDL_Window* pWindow);
+		~Presenter();
+
+		Presenter(const Presenter&) = delete;
+		Presenter(Presenter&&) noexcept = delete;
+		Presenter& operator=(const Presenter&) = delete;
+		Presenter& operator=(Presenter&&) noexcept = delete;
+
+		//The render target must stay untouched until it's released, see WaitUntilReleased
+		void Submit(const RenderTarget* pRenderTarget);
+
+		//Blocks while pRenderTarget is waiting to be presented or being presented
+		void WaitUntilReleased(const RenderTarget* pRenderTarget);
+
+		//Blocks until every submitted frame is presented, after that the window is left alone until Resume.
+		//Frames submitted in between wait for Resume
+		void Pause();
+		void Resume();
+
+	private:
+		SDL_Window* m_pWindow;
+
+		std::thread m_Thread{};
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		const RenderTarget* m_pQueuedTarget{ nullptr };
+		const RenderTarget* m_pPresentingTarget{ nullptr };
+		bool m_IsStopping{ false };
+		bool m_IsPaused{ false };
+
+		void PresentLoop();
+	};
+}
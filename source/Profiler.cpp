@@ -0,0 +1,188 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace dae
+{
+	Profiler& Profiler::GetInstance()
+	{
+		static Profiler profiler{};
+		return profiler;
+	}
+
+	Profiler::Profiler() :
+		m_StartTimestamp{ ReadTimestamp() },
+		m_StartTime{ std::chrono::steady_clock::now() }
+	{
+	}
+
+	const char* Profiler::GetStageName(ProfileStage stage)
+	{
+		constexpr const char* names[]{ "Frame", "VertexTransform", "ClipCull", "Setup", "Raster", "Shading", "Clear", "Present" };
+		static_assert(std::size(names) == size_t(ProfileStage::Count));
+
+		return names[size_t(stage)];
+	}
+
+	void Profiler::SetEnabled(bool isEnabled)
+	{
+		m_IsEnabled = isEnabled;
+
+		if (!isEnabled)
+		{
+			std::fill(std::begin(m_StageTimes), std::end(m_StageTimes), 0.f);
+			m_IsCapturing = false;
+		}
+	}
+
+	void Profiler::SetThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		std::lock_guard lock{ buffer.mutex };
+		buffer.name = name;
+	}
+
+	void Profiler::Record(ProfileStage stage, uint64_t start, uint64_t end)
+	{
+		AddEvent({ stage, false, start, end - start });
+	}
+
+	void Profiler::RecordNested(ProfileStage stage, uint64_t start, uint64_t duration)
+	{
+		AddEvent({ stage, true, start, duration });
+	}
+
+	void Profiler::EndFrame()
+	{
+		if (!m_IsEnabled)
+			return;
+
+		Calibrate();
+
+		uint64_t stageTicks[size_t(ProfileStage::Count)]{};
+
+		std::lock_guard threadsLock{ m_ThreadsMutex };
+		for (const std::unique_ptr<ThreadBuffer>& pBuffer : m_Threads)
+		{
+			std::lock_guard lock{ pBuffer->mutex };
+
+			for (size_t i = pBuffer->nrCountedEvents; i < pBuffer->events.size(); ++i)
+			{
+				const Event& event = pBuffer->events[i];
+				stageTicks[size_t(event.stage)] += event.duration;
+
+				// nested time is part of the raster event around it
+				if (event.isNested)
+					stageTicks[size_t(ProfileStage::Raster)] -= event.duration;
+			}
+
+			if (m_IsCapturing)
+				pBuffer->nrCountedEvents = pBuffer->events.size();
+			else
+			{
+				pBuffer->events.clear();
+				pBuffer->nrCountedEvents = 0;
+			}
+		}
+
+		for (size_t i{}; i < size_t(ProfileStage::Count); ++i)
+			m_StageTimes[i] = float(double(stageTicks[i]) / m_TicksPerMicrosecond / 1000.0);
+	}
+
+	void Profiler::BeginCapture()
+	{
+		std::lock_guard threadsLock{ m_ThreadsMutex };
+		for (const std::unique_ptr<ThreadBuffer>& pBuffer : m_Threads)
+		{
+			std::lock_guard lock{ pBuffer->mutex };
+			pBuffer->events.clear();
+			pBuffer->nrCountedEvents = 0;
+		}
+
+		m_IsCapturing = true;
+	}
+
+	bool Profiler::EndCapture(const std::string& path)
+	{
+		m_IsCapturing = false;
+		Calibrate();
+
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		bool isFirst = true;
+		const auto separate = [&file, &isFirst]()
+		{
+			if (!isFirst)
+				file << ",\n";
+			isFirst = false;
+		};
+
+		std::lock_guard threadsLock{ m_ThreadsMutex };
+		for (const std::unique_ptr<ThreadBuffer>& pBuffer : m_Threads)
+		{
+			std::lock_guard lock{ pBuffer->mutex };
+
+			separate();
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << pBuffer->threadId
+				<< ",\"args\":{\"name\":\"" << (pBuffer->name.empty() ? "Thread " + std::to_string(pBuffer->threadId) : pBuffer->name) << "\"}}";
+
+			for (const Event& event : pBuffer->events)
+			{
+				// time stamps before the profiler started would be negative
+				const double timestamp = (double(event.start) - double(m_StartTimestamp)) / m_TicksPerMicrosecond;
+				const double duration = double(event.duration) / m_TicksPerMicrosecond;
+
+				separate();
+				file << "{\"name\":\"" << GetStageName(event.stage) << "\",\"cat\":\"" << (event.isNested ? "summed" : "scope")
+					<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << pBuffer->threadId
+					<< ",\"ts\":" << timestamp << ",\"dur\":" << duration << "}";
+			}
+
+			pBuffer->events.clear();
+			pBuffer->nrCountedEvents = 0;
+		}
+
+		file << "\n]}\n";
+		return bool(file);
+	}
+
+	Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+	{
+		// every thread registers once, the buffers live as long as the profiler
+		thread_local ThreadBuffer* pThreadBuffer{ nullptr };
+		if (!pThreadBuffer)
+		{
+			std::lock_guard lock{ m_ThreadsMutex };
+			m_Threads.push_back(std::make_unique<ThreadBuffer>());
+			pThreadBuffer = m_Threads.back().get();
+			pThreadBuffer->threadId = uint32_t(m_Threads.size());
+		}
+
+		return *pThreadBuffer;
+	}
+
+	void Profiler::Calibrate()
+	{
+		const uint64_t timestamp = ReadTimestamp();
+		const double elapsedMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_StartTime).count();
+
+		// too short to be accurate, keep the previous estimate
+		if (elapsedMicroseconds > 10000.0)
+			m_TicksPerMicrosecond = double(timestamp - m_StartTimestamp) / elapsedMicroseconds;
+	}
+
+	void Profiler::AddEvent(const Event& event)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		std::lock_guard lock{ buffer.mutex };
+		buffer.events.push_back(event);
+	}
+}
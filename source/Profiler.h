@@ -0,0 +1,192 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace dae
+{
+	enum class ProfileStage
+	{
+		Frame,
+		VertexTransform,
+		ClipCull,
+		Setup,
+		Raster,
+		Shading,
+		Clear,
+		Present,
+		Count
+	};
+
+	//Low overhead timings of the frame stages, per thread. Scopes read the time stamp counter and append
+	//to a buffer of their own thread. Per triangle and per pixel work is summed up by the rasterizer and
+	//recorded once per call as nested events, see RecordNested.
+	//EndFrame turns the events into per stage times; while capturing they're kept for a Chrome trace
+	//(chrome://tracing or https://ui.perfetto.dev).
+	class Profiler final
+	{
+	public:
+		static Profiler& GetInstance();
+
+		Profiler(const Profiler&) = delete;
+		Profiler(Profiler&&) noexcept = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler& operator=(Profiler&&) noexcept = delete;
+
+		static uint64_t ReadTimestamp() { return __rdtsc(); }
+		static const char* GetStageName(ProfileStage stage);
+
+		void SetEnabled(bool isEnabled);
+		bool IsEnabled() const { return m_IsEnabled; }
+
+		//Names the calling thread in the trace
+		void SetThreadName(const std::string& name);
+
+		void Record(ProfileStage stage, uint64_t start, uint64_t end);
+		//Time summed up inside a Raster event, start is where it's drawn in the trace. Subtracted from Raster in the stage times
+		void RecordNested(ProfileStage stage, uint64_t start, uint64_t duration);
+
+		//Called once per frame by the thread that renders
+		void EndFrame();
+		//Milliseconds spent in stage during the last frame, over all threads
+		float GetStageTime(ProfileStage stage) const { return m_StageTimes[size_t(stage)]; }
+
+		void BeginCapture();
+		bool IsCapturing() const { return m_IsCapturing; }
+		//Writes every event since BeginCapture as trace_event JSON
+		bool EndCapture(const std::string& path);
+
+	private:
+		struct Event
+		{
+			ProfileStage stage{};
+			bool isNested{};
+			uint64_t start{};
+			uint64_t duration{};
+		};
+
+		struct ThreadBuffer
+		{
+			uint32_t threadId{};
+			std::string name{};
+			std::mutex mutex{};
+			std::vector<Event> events{};
+			// events before this index are already counted in the stage times
+			size_t nrCountedEvents{};
+		};
+
+		Profiler();
+		~Profiler() = default;
+
+		std::atomic<bool> m_IsEnabled{ false };
+		std::atomic<bool> m_IsCapturing{ false };
+
+		std::mutex m_ThreadsMutex{};
+		std::vector<std::unique_ptr<ThreadBuffer>> m_Threads{};
+
+		// ticks to time, measured against the steady clock
+		uint64_t m_StartTimestamp{};
+		std::chrono::steady_clock::time_point m_StartTime{};
+		double m_TicksPerMicrosecond{ 1000.0 };
+
+		float m_StageTimes[size_t(ProfileStage::Count)]{};
+
+		ThreadBuffer& GetThreadBuffer();
+		void Calibrate();
+		void AddEvent(const Event& event);
+	};
+
+	//Records the time until the end of the scope, when the profiler is enabled
+	class ProfileScope final
+	{
+	public:
+		explicit ProfileScope(ProfileStage stage) :
+			m_Stage{ stage },
+			m_Start{ Profiler::GetInstance().IsEnabled() ? Profiler::ReadTimestamp() : 0 }
+		{
+		}
+
+		~ProfileScope()
+		{
+			if (m_Start)
+				Profiler::GetInstance().Record(m_Stage, m_Start, Profiler::ReadTimestamp());
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope(ProfileScope&&) noexcept = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+		ProfileScope& operator=(ProfileScope&&) noexcept = delete;
+
+	private:
+		ProfileStage m_Stage;
+		uint64_t m_Start;
+	};
+
+	//Sums up short pieces of work that repeat too often for an event each, e.g. per triangle or per pixel.
+	//Lap adds the time since the last Lap or Restart to a stage, the sums are recorded as nested events
+	//when the timer goes out of scope
+	class NestedStageTimer final
+	{
+	public:
+		NestedStageTimer() :
+			m_IsEnabled{ Profiler::GetInstance().IsEnabled() },
+			m_Start{ m_IsEnabled ? Profiler::ReadTimestamp() : 0 },
+			m_LapStart{ m_Start }
+		{
+		}
+
+		~NestedStageTimer()
+		{
+			if (!m_IsEnabled)
+				return;
+
+			// drawn back to back from the start, only the lengths mean something
+			uint64_t start = m_Start;
+			for (size_t i{}; i < size_t(ProfileStage::Count); ++i)
+			{
+				if (m_Ticks[i] == 0)
+					continue;
+
+				Profiler::GetInstance().RecordNested(ProfileStage(i), start, m_Ticks[i]);
+				start += m_Ticks[i];
+			}
+		}
+
+		NestedStageTimer(const NestedStageTimer&) = delete;
+		NestedStageTimer(NestedStageTimer&&) noexcept = delete;
+		NestedStageTimer& operator=(const NestedStageTimer&) = delete;
+		NestedStageTimer& operator=(NestedStageTimer&&) noexcept = delete;
+
+		void Restart()
+		{
+			if (m_IsEnabled)
+				m_LapStart = Profiler::ReadTimestamp();
+		}
+
+		void Lap(ProfileStage stage)
+		{
+			if (!m_IsEnabled)
+				return;
+
+			const uint64_t now = Profiler::ReadTimestamp();
+			m_Ticks[size_t(stage)] += now - m_LapStart;
+			m_LapStart = now;
+		}
+
+	private:
+		const bool m_IsEnabled;
+		const uint64_t m_Start;
+		uint64_t m_LapStart;
+		uint64_t m_Ticks[size_t(ProfileStage::Count)]{};
+	};
+}
@@ -0,0 +1,122 @@
+#include "RenderTarget.h"
+#include <SDL_surface.h>
+#include <algorithm>
+#include <new>
+
+namespace dae
+{
+	RenderTarget::RenderTarget(int width, int height, DepthFormat depthFormat) :
+		m_Width{ width },
+		m_Height{ height },
+		m_DepthFormat{ depthFormat }
+	{
+		const size_t nrPixels = size_t(width) * height;
+
+		m_pColorBuffer = static_cast<uint32_t*>(::operator new[](nrPixels * sizeof(uint32_t), std::align_val_t{ BufferAlignment }));
+		AllocateDepthBuffer();
+
+		m_pSurface = SDL_CreateRGBSurfaceWithFormatFrom(m_pColorBuffer, width, height, 32, width * int(sizeof(uint32_t)), SDL_PIXELFORMAT_ARGB8888);
+
+		m_NrTilesX = (width + TileSize - 1) / TileSize;
+		m_NrTilesY = (height + TileSize - 1) / TileSize;
+		m_IsTileCleared.resize(size_t(m_NrTilesX) * m_NrTilesY);
+	}
+
+	RenderTarget::~RenderTarget()
+	{
+		SDL_FreeSurface(m_pSurface);
+
+		::operator delete[](m_pColorBuffer, std::align_val_t{ BufferAlignment });
+		FreeDepthBuffer();
+	}
+
+	void RenderTarget::SetDepthFormat(DepthFormat depthFormat)
+	{
+		if (depthFormat == m_DepthFormat)
+			return;
+
+		FreeDepthBuffer();
+		m_DepthFormat = depthFormat;
+		AllocateDepthBuffer();
+
+		// every tile has to be cleared again in the new format
+		std::fill(m_IsTileCleared.begin(), m_IsTileCleared.end(), uint8_t{ 0 });
+	}
+
+	void RenderTarget::BeginFrame(uint32_t clearColor, float clearDepth)
+	{
+		m_ClearColor = clearColor;
+		m_ClearDepthBits = DepthBuffer::Encode(m_DepthFormat, clearDepth);
+
+		std::fill(m_IsTileCleared.begin(), m_IsTileCleared.end(), uint8_t{ 0 });
+	}
+
+	void RenderTarget::ClearRegion(int left, int top, int right, int bottom)
+	{
+		const int firstTileX = std::max(left, 0) / TileSize;
+		const int firstTileY = std::max(top, 0) / TileSize;
+		const int lastTileX = std::min(right / TileSize, m_NrTilesX - 1);
+		const int lastTileY = std::min(bottom / TileSize, m_NrTilesY - 1);
+
+		for (int tileY = firstTileY; tileY <= lastTileY; ++tileY)
+		{
+			for (int tileX = firstTileX; tileX <= lastTileX; ++tileX)
+			{
+				uint8_t& isCleared = m_IsTileCleared[tileX + tileY * m_NrTilesX];
+				if (isCleared)
+					continue;
+
+				ClearTile(tileX, tileY, true);
+				isCleared = 1;
+			}
+		}
+	}
+
+	void RenderTarget::ResolveUntouchedTiles()
+	{
+		for (int tileY{}; tileY < m_NrTilesY; ++tileY)
+		{
+			for (int tileX{}; tileX < m_NrTilesX; ++tileX)
+			{
+				// nothing reads the depth of a tile nothing was drawn to
+				if (!m_IsTileCleared[tileX + tileY * m_NrTilesX])
+					ClearTile(tileX, tileY, false);
+			}
+		}
+	}
+
+	void RenderTarget::ClearTile(int tileX, int tileY, bool clearDepth)
+	{
+		const int left = tileX * TileSize;
+		const int top = tileY * TileSize;
+		const int width = std::min(TileSize, m_Width - left);
+		const int height = std::min(TileSize, m_Height - top);
+
+		// color and depth row by row in one pass
+		for (int y = top; y < top + height; ++y)
+		{
+			const size_t rowStart = size_t(y) * m_Width + left;
+
+			std::fill_n(m_pColorBuffer + rowStart, width, m_ClearColor);
+			if (!clearDepth)
+				continue;
+
+			if (GetDepthFormatSize(m_DepthFormat) == sizeof(uint16_t))
+				std::fill_n(static_cast<uint16_t*>(m_pDepthData) + rowStart, width, static_cast<uint16_t>(m_ClearDepthBits));
+			else
+				std::fill_n(static_cast<uint32_t*>(m_pDepthData) + rowStart, width, m_ClearDepthBits);
+		}
+	}
+
+	void RenderTarget::AllocateDepthBuffer()
+	{
+		const size_t nrPixels = size_t(m_Width) * m_Height;
+		m_pDepthData = ::operator new[](nrPixels * GetDepthFormatSize(m_DepthFormat), std::align_val_t{ BufferAlignment });
+	}
+
+	void RenderTarget::FreeDepthBuffer()
+	{
+		::operator delete[](m_pDepthData, std::align_val_t{ BufferAlignment });
+		m_pDepthData = nullptr;
+	}
+}
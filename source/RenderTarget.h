@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "DepthBuffer.h"
+
+struct SDL_Surface;
+
+namespace dae
+{
+	//Color + depth buffer the renderer draws into, independent of any window.
+	//Clearing is lazy and per tile: BeginFrame only forgets which tiles are cleared, the rasterizer clears
+	//color and depth of a tile together the first time it touches it, and ResolveUntouchedTiles fills the
+	//tiles nothing was drawn to with the clear color. The depth of untouched tiles is left undefined.
+	class RenderTarget final
+	{
+	public:
+		RenderTarget(int width, int height, DepthFormat depthFormat = DepthFormat::Float32);
+		~RenderTarget();
+
+		RenderTarget(const RenderTarget&) = delete;
+		RenderTarget(RenderTarget&&) noexcept = delete;
+		RenderTarget& operator=(const RenderTarget&) = delete;
+		RenderTarget& operator=(RenderTarget&&) noexcept = delete;
+
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+
+		uint32_t* GetColorBuffer() const { return m_pColorBuffer; }
+		//Only for Float32 depth, nullptr otherwise
+		float* GetDepthBuffer() const { return m_DepthFormat == DepthFormat::Float32 ? static_cast<float*>(m_pDepthData) : nullptr; }
+		void* GetDepthData() const { return m_pDepthData; }
+
+		DepthFormat GetDepthFormat() const { return m_DepthFormat; }
+		//Reallocates the depth buffer, its contents are lost
+		void SetDepthFormat(DepthFormat depthFormat);
+
+		//ARGB8888 surface over the color buffer (no copy), for SDL fills, blits and saves
+		SDL_Surface* GetSurface() const { return m_pSurface; }
+
+		static constexpr int TileSize{ 32 };
+
+		void BeginFrame(uint32_t clearColor, float clearDepth);
+		//Clears the tiles overlapping the pixel rectangle [left, right] x [top, bottom] that aren't cleared yet
+		void ClearRegion(int left, int top, int right, int bottom);
+		void ResolveUntouchedTiles();
+
+		int GetNrTilesX() const { return m_NrTilesX; }
+		int GetNrTilesY() const { return m_NrTilesY; }
+		bool IsTileCleared(int tileX, int tileY) const { return m_IsTileCleared[tileX + tileY * m_NrTilesX]; }
+
+	private:
+		// cache line aligned, so rows and tiles can be processed with aligned SIMD
+		static constexpr size_t BufferAlignment{ 64 };
+
+		int m_Width{};
+		int m_Height{};
+
+		uint32_t* m_pColorBuffer{ nullptr };
+		void* m_pDepthData{ nullptr };
+		DepthFormat m_DepthFormat{};
+		SDL_Surface* m_pSurface{ nullptr };
+
+		int m_NrTilesX{};
+		int m_NrTilesY{};
+		std::vector<uint8_t> m_IsTileCleared{};
+		uint32_t m_ClearColor{};
+		uint32_t m_ClearDepthBits{};
+
+		void ClearTile(int tileX, int tileY, bool clearDepth);
+		void AllocateDepthBuffer();
+		void FreeDepthBuffer();
+	};
+}
@@ -4,11 +4,21 @@
 
 //Project includes
 #include "Renderer.h"
+#include "PixelPacking.h"
+#include "PipelineStatistics.h"
+#include "Presenter.h"
+#include "Profiler.h"
+#include "RenderTarget.h"
+#include "SimdKernels.h"
 #include "Math.h"
 #include "Matrix.h"
 #include "Texture.h"
-#include "Utils.h"
+#include "TriangleSetup.h"
 #include "BRDF.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 
 #define INT int
@@ -19,41 +29,63 @@
 using namespace dae;
 
 Renderer::Renderer(SDL_Window* pWindow) :
-	m_pWindow(pWindow),
 	m_IsRotating(false),
 	m_EnableNormalMap(true)
 {
 	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+	int width{}, height{};
+	SDL_GetWindowSize(pWindow, &width, &height);
+
+	m_pPresenter = new Presenter{ pWindow };
+
+	Initialize(width, height, NrWindowRenderTargets, {});
+}
+
+Renderer::Renderer(int width, int height, const std::string& meshPath) :
+	m_IsRotating(false),
+	m_EnableNormalMap(true)
+{
+	// Headless: no window, frames stay in the render target
+	Initialize(width, height, 1, meshPath);
+}
+
+Renderer::~Renderer()
+{
+	// the present thread may still be reading a render target
+	delete m_pPresenter;
+
+	for (RenderTarget* pRenderTarget : m_RenderTargets)
+		delete pRenderTarget;
+}
+
+void Renderer::Initialize(int width, int height, int nrRenderTargets, const std::string& meshPath)
+{
+	m_Width = width;
+	m_Height = height;
+	m_OutputWidth = width;
+	m_OutputHeight = height;
 
 	//Create Buffers
-	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+	for (int i{}; i < nrRenderTargets; ++i)
+		m_RenderTargets.push_back(new RenderTarget{ m_Width, m_Height });
+	SetRenderTarget(0);
 
-	m_pDepthBufferPixels = new float[(int)(m_Width * m_Height)];
+	Profiler::GetInstance().SetThreadName("Render");
 
 	// This way the Camera::CalculateProjectionMatrix is only called when the FOV or AspectRatio is changed
 	// see definition 
 	SetAspectRatio((float)m_Width / (float)m_Height);
 
 
-	m_pUVGridTexture = Texture::LoadFromFile("Resources/uv_grid_2.png");
+	m_UVGridTexture = m_TextureCache.Load("Resources/uv_grid_2.png");
 #ifdef MESH_TUKTUK
 	SetFovAngle(60.f);
 
-	m_pTukTukTexture = Texture::LoadFromFile("resources/tuktuk.png");
-
-	TukTukMeshInit();
+	TukTukMeshInit(meshPath);
 #elif defined(MESH_VEHICLE)
 	SetFovAngle(45.f);
 
-	m_pVehicleDiffuse = Texture::LoadFromFile("resources/vehicle_diffuse.png");
-	m_pVehicleNormalMap = Texture::LoadFromFile("resources/vehicle_normal.png");
-	m_pGlossinessMap = Texture::LoadFromFile("resources/vehicle_gloss.png");
-	m_pSpecularMap = Texture::LoadFromFile("resources/vehicle_specular.png");
-
-	VehicleMeshInit();
+	VehicleMeshInit(meshPath);
 #endif
 
 	//Initialize Camera
@@ -64,21 +96,12 @@ Renderer::Renderer(SDL_Window* pWindow) :
 
 }
 
-Renderer::~Renderer()
-{
-	delete[] m_pDepthBufferPixels;
-	delete m_pUVGridTexture;
-	delete m_pTukTukTexture;
-	delete m_pVehicleDiffuse;
-	delete m_pVehicleNormalMap;
-	delete m_pGlossinessMap;
-	delete m_pSpecularMap;
-}
-
 void Renderer::Update(Timer* pTimer)
 {
 	m_Camera.Update(pTimer);
 
+	PollLoading();
+
 	if (m_IsRotating)
 	{
 		constexpr float rotationSpeed{ 30 * TO_RADIANS };
@@ -90,8 +113,39 @@ void Renderer::Update(Timer* pTimer)
 	}
 }
 
-void Renderer::Render() const
+void Renderer::WaitForLoading()
+{
+	m_MeshLoader.WaitUntilFinished();
+	PollLoading();
+}
+
+void Renderer::PollLoading()
 {
+	// Append whatever the background loader finished since last frame
+#ifdef MESH_TUKTUK
+	if (m_MeshLoader.PollChunks(m_TukTukMesh))
+		UpdateMaterialTextures(m_TukTukMesh);
+#elif defined(MESH_VEHICLE)
+	if (m_MeshLoader.PollChunks(m_VehicleMesh))
+		UpdateMaterialTextures(m_VehicleMesh);
+#endif
+}
+
+void Renderer::Render()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	const uint64_t frameStart = Profiler::ReadTimestamp();
+	m_Statistics = {};
+
+	// the next target may still be queued for or being copied to the window
+	if (m_pPresenter)
+	{
+		// without a pause in between the previous frame goes out now
+		SubmitFinishedTarget();
+		SetRenderTarget((m_CurrentRenderTarget + 1) % m_RenderTargets.size());
+		m_pPresenter->WaitUntilReleased(m_pRenderTarget);
+	}
+
 	//@START
 	//Lock BackBuffer
 	SDL_LockSurface(m_pBackBuffer);
@@ -113,10 +167,137 @@ void Renderer::Render() const
 	Render_W4();
 #endif
 	//@END
-	//Update SDL Surface
 	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
+
+	// presenting is optional, headless frames just stay in the render target. The frame is submitted after
+	// the window events, so the present thread copies it while the next one renders
+	if (m_pPresenter)
+		m_pFinishedTarget = m_pRenderTarget;
+
+	if (m_IsDynamicResolution)
+		UpdateResolutionScale(std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count());
+
+	Profiler& profiler = Profiler::GetInstance();
+	if (profiler.IsEnabled())
+	{
+		profiler.Record(ProfileStage::Frame, frameStart, Profiler::ReadTimestamp());
+		profiler.EndFrame();
+	}
+}
+
+void Renderer::PausePresenting()
+{
+	if (m_pPresenter)
+		m_pPresenter->Pause();
+	m_IsPresentingPaused = true;
+}
+
+void Renderer::ResumePresenting()
+{
+	m_IsPresentingPaused = false;
+	if (!m_pPresenter)
+		return;
+
+	m_pPresenter->Resume();
+	SubmitFinishedTarget();
+}
+
+void Renderer::SubmitFinishedTarget()
+{
+	if (!m_pFinishedTarget)
+		return;
+
+	m_pPresenter->Submit(m_pFinishedTarget);
+	m_pFinishedTarget = nullptr;
+}
+
+void Renderer::Resize(int width, int height)
+{
+	// the size comes from a window event, the old window surface may already be gone
+	assert((!m_pPresenter || m_IsPresentingPaused) && "Resize while presenting is paused, see PausePresenting");
+
+	if (width <= 0 || height <= 0)
+		return;
+
+	m_OutputWidth = width;
+	m_OutputHeight = height;
+	SetAspectRatio((float)m_OutputWidth / (float)m_OutputHeight);
+
+	SetRenderResolution(std::max(1, int(m_OutputWidth * m_ResolutionScale)), std::max(1, int(m_OutputHeight * m_ResolutionScale)));
+}
+
+void Renderer::SetDynamicResolution(bool isEnabled, float targetFrameTime)
+{
+	m_IsDynamicResolution = isEnabled;
+	m_TargetFrameTime = targetFrameTime;
+
+	// back to native until the first frame is measured
+	m_ResolutionScale = 1.f;
+	SetRenderResolution(m_OutputWidth, m_OutputHeight);
+}
+
+void Renderer::UpdateResolutionScale(float renderTime)
+{
+	float scale = m_ResolutionScale;
+	if (renderTime > m_TargetFrameTime)
+	{
+		// the cost is about proportional to the pixel count, the square of the scale
+		const float idealScale = m_ResolutionScale * std::sqrt(m_TargetFrameTime / renderTime);
+		scale = std::floor(idealScale / ResolutionScaleStep) * ResolutionScaleStep;
+	}
+	else if (renderTime < m_TargetFrameTime * 0.8f)
+	{
+		// step up slowly and only with some headroom, so it doesn't flip between two steps
+		scale += ResolutionScaleStep;
+	}
+
+	scale = std::clamp(scale, MinResolutionScale, 1.f);
+	if (scale == m_ResolutionScale)
+		return;
+
+	m_ResolutionScale = scale;
+	SetRenderResolution(std::max(1, int(m_OutputWidth * m_ResolutionScale)), std::max(1, int(m_OutputHeight * m_ResolutionScale)));
+}
+
+void Renderer::SetRenderResolution(int width, int height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	// the present thread can't be reading any of them
+	if (m_pPresenter)
+	{
+		for (const RenderTarget* pRenderTarget : m_RenderTargets)
+			m_pPresenter->WaitUntilReleased(pRenderTarget);
+	}
+
+	const DepthFormat depthFormat = m_pRenderTarget->GetDepthFormat();
+
+	m_Width = width;
+	m_Height = height;
+
+	for (RenderTarget*& pRenderTarget : m_RenderTargets)
+	{
+		delete pRenderTarget;
+		pRenderTarget = new RenderTarget{ m_Width, m_Height, depthFormat };
+	}
+	SetRenderTarget(0);
+	// the frame that wasn't submitted yet is gone with its target
+	m_pFinishedTarget = nullptr;
+}
+
+void Renderer::SetRenderTarget(size_t index)
+{
+	m_CurrentRenderTarget = index;
+	m_pRenderTarget = m_RenderTargets[index];
+
+	m_pBackBuffer = m_pRenderTarget->GetSurface();
+	m_pBackBufferPixels = m_pRenderTarget->GetColorBuffer();
+	m_PixelLayout = PixelLayout::FromFormat(m_pBackBuffer->format);
+	m_BackgroundColor = SDL_MapRGB(m_pBackBuffer->format, 100, 100, 100);
+
+	m_pDepthBufferPixels = m_pRenderTarget->GetDepthBuffer();
+	m_DepthBuffer = DepthBuffer{ m_pRenderTarget->GetDepthFormat(), m_pRenderTarget->GetDepthData(), m_Camera.isReversedZ };
 }
 
 void Renderer::VertexTransformationFunction_W1(const std::vector<Vertex>& vertices_in, std::vector<Vertex>& vertices_out) const
@@ -201,40 +382,64 @@ void Renderer::VertexTransformationFunction_W3(std::vector<Mesh>& meshes) const
 		}
 	}
 }
-void Renderer::VertexTransformationFunction_W4(std::vector<Mesh>& meshes) const
+void Renderer::VertexTransformationFunction_W4(Mesh& m) const
 {
-	for (auto& m : meshes)
-	{
-		m.vertices_out.clear();
-		m.vertices_out.reserve(m.vertices.size());
+	// the outputs live on the mesh, they only grow while it streams in
+	const size_t nrVertices = m.vertices.size();
+	m.vertices_out.resize(nrVertices);
 
-		Matrix worldViewProjectionMatrix = m.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix;
+	Matrix worldViewProjectionMatrix = m.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix;
 
-		for (const auto& v : m.vertices)
+	// a mesh that wasn't built through MeshLoader::PollChunks has no position stream that matches yet
+	if (m.positions.x.size() != nrVertices)
+	{
+		m.positions.x.resize(nrVertices);
+		m.positions.y.resize(nrVertices);
+		m.positions.z.resize(nrVertices);
+		for (size_t i{}; i < nrVertices; ++i)
 		{
-			Vertex_Out vertexOut{};
-
-			// to NDC-Space
-			vertexOut.position = worldViewProjectionMatrix.TransformPoint(v.position.ToVector4());
-
-			vertexOut.viewDirection = Vector3{ vertexOut.position.GetXYZ() };
-			vertexOut.viewDirection.Normalize();
-
-			vertexOut.position.x /= vertexOut.position.w;
-			vertexOut.position.y /= vertexOut.position.w;
-			vertexOut.position.z /= vertexOut.position.w;
-
-			vertexOut.color = v.color;
-			vertexOut.normal = m.worldMatrix.TransformVector(v.normal).Normalized();
-			vertexOut.uv = v.uv;
-			vertexOut.tangent = m.worldMatrix.TransformVector(v.tangent).Normalized();
-
-			m.vertices_out.emplace_back(vertexOut);
+			m.positions.x[i] = m.vertices[i].position.x;
+			m.positions.y[i] = m.vertices[i].position.y;
+			m.positions.z[i] = m.vertices[i].position.z;
 		}
 	}
+
+	// all positions to clip space in one go, 4 to 16 per iteration depending on the CPU
+	VertexStream& positions = m.positions_out;
+	positions.x.resize(nrVertices);
+	positions.y.resize(nrVertices);
+	positions.z.resize(nrVertices);
+	positions.w.resize(nrVertices);
+	GetSimdKernels().transformPoints(worldViewProjectionMatrix.GetData(),
+		m.positions.x.data(), m.positions.y.data(), m.positions.z.data(),
+		positions.x.data(), positions.y.data(), positions.z.data(), positions.w.data(), nrVertices);
+
+	for (size_t i{}; i < nrVertices; ++i)
+	{
+		const Vertex& v = m.vertices[i];
+		Vertex_Out& vertexOut = m.vertices_out[i];
+
+		const float w = positions.w[i];
+
+		vertexOut.viewDirection = Vector3{ positions.x[i], positions.y[i], positions.z[i] };
+		// shading uses the clip position, keep it the same for both depth conventions
+		if (m_Camera.isReversedZ)
+			vertexOut.viewDirection.z = w - positions.z[i];
+		vertexOut.viewDirection.Normalize();
+
+		// to NDC-Space in place, w stays for the perspective correct interpolation
+		positions.x[i] /= w;
+		positions.y[i] /= w;
+		positions.z[i] /= w;
+
+		vertexOut.color = v.color;
+		vertexOut.normal = m.worldMatrix.TransformVector(v.normal).Normalized();
+		vertexOut.uv = v.uv;
+		vertexOut.tangent = m.worldMatrix.TransformVector(v.tangent).Normalized();
+	}
 }
 
-void Renderer::PixelShading(Vertex_Out& v) const
+void Renderer::PixelShading(Vertex_Out& v, const MaterialTextures& material) const
 {
 	ColorRGB tempColor{ colors::Black };
 
@@ -244,13 +449,14 @@ void Renderer::PixelShading(Vertex_Out& v) const
 
 	Vector3 normal;
 
-	if (m_EnableNormalMap)
+	const Texture* pNormalMap = material.normal.Get();
+	if (m_EnableNormalMap && pNormalMap)
 	{
 		// Normal map
 		const Vector3 biNormal = Vector3::Cross(v.normal, v.tangent);
 		const Matrix tangentSpaceAxis = { v.tangent, biNormal, v.normal, Vector3::Zero };
 
-		const ColorRGB normalColor = m_pVehicleNormalMap->Sample(v.uv);
+		const ColorRGB normalColor = pNormalMap->Sample(v.uv);
 		Vector3 sampledNormal = { normalColor.r, normalColor.g, normalColor.b }; // => range [0, 1]
 		sampledNormal = 2.f * sampledNormal - Vector3{ 1, 1, 1 }; // => [0, 1] to [-1, 1]
 
@@ -272,8 +478,13 @@ void Renderer::PixelShading(Vertex_Out& v) const
 
 	ColorRGB diffuse;
 
+	// maps the material doesn't have fall back to white diffuse, full gloss and no specular
+	const Texture* pDiffuseMap = material.diffuse.Get();
+	const Texture* pGlossinessMap = material.glossiness.Get();
+	const Texture* pSpecularMap = material.specular.Get();
+
 	// phong specular
-	const ColorRGB gloss = m_pGlossinessMap->Sample(v.uv);
+	const ColorRGB gloss = pGlossinessMap ? pGlossinessMap->Sample(v.uv) : colors::White;
 	const float exponent = gloss.r * specularShininess;
 
 	ColorRGB specular;
@@ -285,18 +496,18 @@ void Renderer::PixelShading(Vertex_Out& v) const
 		tempColor += observedArea;
 		break;
 	case ShadingMode::Diffuse:
-		diffuse = BRDF::Lambert(m_pVehicleDiffuse->Sample(v.uv));
+		diffuse = BRDF::Lambert(pDiffuseMap ? pDiffuseMap->Sample(v.uv) : colors::White);
 
 		tempColor += diffuse * observedArea * lightIntensity;
 		break;
 	case ShadingMode::Specular:
-		specular = BRDF::Phong(m_pSpecularMap->Sample(v.uv), exponent, directionToLight, v.viewDirection, normal);
+		specular = BRDF::Phong(pSpecularMap ? pSpecularMap->Sample(v.uv) : colors::Black, exponent, directionToLight, v.viewDirection, normal);
 
 		tempColor += specular * observedArea;
 		break;
 	case ShadingMode::Combined:		 
-		specular = BRDF::Phong(m_pSpecularMap->Sample(v.uv), exponent, directionToLight, v.viewDirection, normal);
-		diffuse = BRDF::Lambert(m_pVehicleDiffuse->Sample(v.uv));
+		specular = BRDF::Phong(pSpecularMap ? pSpecularMap->Sample(v.uv) : colors::Black, exponent, directionToLight, v.viewDirection, normal);
+		diffuse = BRDF::Lambert(pDiffuseMap ? pDiffuseMap->Sample(v.uv) : colors::White);
 
 		tempColor += diffuse * observedArea * lightIntensity + specular;
 		break;
@@ -362,10 +573,7 @@ void dae::Renderer::Render_W1_Part1() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
@@ -429,10 +637,7 @@ void dae::Renderer::Render_W1_Part2() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
@@ -502,10 +707,7 @@ void dae::Renderer::Render_W1_Part3() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
@@ -598,10 +800,7 @@ void dae::Renderer::Render_W1_Part4() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
@@ -710,10 +909,7 @@ void dae::Renderer::Render_W1_Part5() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}	
@@ -837,10 +1033,7 @@ void dae::Renderer::Render_W2_Part1() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
@@ -981,10 +1174,7 @@ void dae::Renderer::Render_W2_Part2() const
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
@@ -1103,17 +1293,14 @@ void dae::Renderer::Render_W2_Part3() const
 
 				const Vector2 weightedUV = uvV0 * weightV0 + uvV1 * weightV1 + uvV2 * weightV2;
 
-				finalColor = m_pUVGridTexture->Sample(weightedUV);
+				finalColor = m_UVGridTexture->Sample(weightedUV);
 
 				//finalColor = colorV0 * weightV0 + colorV1 * weightV1 + colorV2 * weightV2;
 
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}	
@@ -1240,15 +1427,12 @@ void dae::Renderer::Render_W2_Part4() const
 					(uvV2 / depthV2) * weightV2) * interpolatedDepthWeight
 				};
 				
-				finalColor = m_pUVGridTexture->Sample(interpolatedUV);
+				finalColor = m_UVGridTexture->Sample(interpolatedUV);
 				
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
@@ -1257,34 +1441,70 @@ void dae::Renderer::Render_W2_Part4() const
 #pragma region Week3
 void Renderer::Render_W3() const
 {
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	{
+		ProfileScope clearScope{ ProfileStage::Clear };
 
-	ClearBackground();
-	
-	std::vector<Mesh> meshes_world{ m_TukTukMesh };
+		// tiles are cleared when the first triangle touches them
+		m_pRenderTarget->BeginFrame(m_BackgroundColor, m_DepthBuffer.GetFarDepth());
+	}
 
-	VertexTransformationFunction_W3(meshes_world);
+	ResetHeatmap();
+
+	std::vector<Mesh> meshes_world{};
+	{
+		ProfileScope vertexScope{ ProfileStage::VertexTransform };
+
+		meshes_world.push_back(m_TukTukMesh);
+		VertexTransformationFunction_W3(meshes_world);
+	}
 
 	for (auto& m : meshes_world)
 	{
+		ProfileScope rasterScope{ ProfileStage::Raster };
+
 		switch (m_TukTukMesh.primitiveTopology)
 		{
 		case PrimitiveTopology::TriangleList:
-			RenderTriangleListW3(m);
+			for (const SubMesh& subMesh : m.subMeshes)
+				RenderTriangleListW3(m, subMesh, GetMaterialTextures(subMesh.materialIndex));
 			break;
 		case PrimitiveTopology::TriangleStrip:
-			RenderTriangleStripW3(m);
+			RenderTriangleStripW3(m, GetMaterialTextures(m.subMeshes.empty() ? SubMesh::NoMaterial : m.subMeshes[0].materialIndex));
 			break;
 		}
 	}
+
+	// triangle strips still write the depth colors per pixel
+	if (m_CurrentDisplayMode == DisplayMode::DepthBuffer && m_TukTukMesh.primitiveTopology == PrimitiveTopology::TriangleList)
+	{
+		ProfileScope shadingScope{ ProfileStage::Shading };
+		ResolveDepthView(0.985f);
+	}
+
+	{
+		ProfileScope clearScope{ ProfileStage::Clear };
+		m_pRenderTarget->ResolveUntouchedTiles();
+	}
+
+	// covers the whole target, the background included
+	ProfileScope shadingScope{ ProfileStage::Shading };
+	ResolveHeatmap();
 }
 
-void Renderer::RenderTriangleListW3(Mesh& mesh) const
+void Renderer::RenderTriangleListW3(Mesh& mesh, const SubMesh& subMesh, const MaterialTextures& material) const
 {
 	ColorRGB finalColor{ };
+	PipelineStatistics statistics{};
 
-	for (size_t i{}; i < mesh.indices.size(); i += 3)
+	// only the heatmap that's displayed is filled in
+	uint32_t* const pOverdrawCounts = m_CurrentDisplayMode == DisplayMode::Overdraw ? m_HeatmapCounts.data() : nullptr;
+	uint32_t* const pDepthFailCounts = m_CurrentDisplayMode == DisplayMode::DepthFailures ? m_HeatmapCounts.data() : nullptr;
+	const bool isTimingBlocks = m_CurrentDisplayMode == DisplayMode::RasterTime;
+
+	for (size_t i{ subMesh.indexOffset }; i < size_t(subMesh.indexOffset) + subMesh.indexCount; i += 3)
 	{
+		++statistics.nrInputTriangles;
+
 		Vertex_Out vOut0 = mesh.vertices_out[mesh.indices[i]];
 		Vertex_Out vOut1 = mesh.vertices_out[mesh.indices[i + 1]];
 		Vertex_Out vOut2 = mesh.vertices_out[mesh.indices[i + 2]];
@@ -1293,7 +1513,10 @@ void Renderer::RenderTriangleListW3(Mesh& mesh) const
 		if (!IsInFrustum(vOut0)
 			|| !IsInFrustum(vOut1)
 			|| !IsInFrustum(vOut2))
+		{
+			++statistics.nrFrustumCulledTriangles;
 			continue;
+		}
 
 		// from NDC space to Raster space
 		NDCToRaster(vOut0);
@@ -1308,7 +1531,16 @@ void Renderer::RenderTriangleListW3(Mesh& mesh) const
 		const Vector2 edge12 = v2 - v1;
 		const Vector2 edge20 = v0 - v2;
 
-		const float reversedAreaTriangle = 1 / Vector2::Cross(edge01, edge12);
+		const float areaTriangle = Vector2::Cross(edge01, edge12);
+
+		// pixels are only inside when all weights are positive, that can't happen for a negative area
+		if (areaTriangle <= 0)
+		{
+			++statistics.nrBackFaceCulledTriangles;
+			continue;
+		}
+
+		const float reversedAreaTriangle = 1 / areaTriangle;
 
 		// create bounding box for triangle
 		const INT top = std::max((INT)std::max(v0.y, v1.y), (INT)v2.y);
@@ -1318,14 +1550,21 @@ void Renderer::RenderTriangleListW3(Mesh& mesh) const
 		const INT right = std::max((INT)std::max(v0.x, v1.x), (INT)v2.x);
 
 		// check if bounding box is in screen
-		if (left <= 0 || right >= m_Width - 1)
-			continue;
-
-		if (bottom <= 0 || top >= m_Height - 1)
+		if (left <= 0 || right >= m_Width - 1
+			|| bottom <= 0 || top >= m_Height - 1)
+		{
+			++statistics.nrOffScreenTriangles;
 			continue;
+		}
 
 		constexpr INT offSet{ 1 };
 
+		statistics.nrPixelsTested += uint64_t(right - left + 2 * offSet) * uint64_t(top - bottom + 2 * offSet);
+
+		const uint64_t rasterStart = isTimingBlocks ? Profiler::ReadTimestamp() : 0;
+
+		m_pRenderTarget->ClearRegion(left - offSet, bottom - offSet, right + offSet - 1, top + offSet - 1);
+
 		// iterate over every pixel in the bounding box, with an offset we enlarge the BB
 		// in case of overlooked pixels
 		for (INT px = left - offSet; px < right + offSet; ++px)
@@ -1354,6 +1593,8 @@ void Renderer::RenderTriangleListW3(Mesh& mesh) const
 				if (weightV1 < 0)
 					continue;
 
+				++statistics.nrPixelsCovered;
+
 				weightV0 *= reversedAreaTriangle;
 				weightV1 *= reversedAreaTriangle;
 				weightV2 *= reversedAreaTriangle;
@@ -1364,25 +1605,30 @@ void Renderer::RenderTriangleListW3(Mesh& mesh) const
 
 				// This Z-BufferValue is the one we compare in the Depth Test and
 				// the value we store in the Depth Buffer (uses position.z).
-				float interpolatedZDepth = {
-					1.f /
-					((1 / vOut0.position.z) * weightV0 +
-					(1 / vOut1.position.z) * weightV1 +
-					(1 / vOut2.position.z) * weightV2)
-				};
+				// NDC depth is linear in screen space, unlike the attributes below. The weighted
+				// harmonic mean used before was close enough near 1, but not for reversed-Z near 0
+				float interpolatedZDepth = vOut0.position.z * weightV0 + vOut1.position.z * weightV1 + vOut2.position.z * weightV2;
 
 				if (interpolatedZDepth < 0 || interpolatedZDepth > 1)
 					continue;
 
 
-				if (interpolatedZDepth > m_pDepthBufferPixels[px + (py * m_Width)])
-					continue;
+				if (pOverdrawCounts)
+					++pOverdrawCounts[px + (py * m_Width)];
 
-				m_pDepthBufferPixels[px + (py * m_Width)] = interpolatedZDepth;
+				if (!m_DepthBuffer.TestAndWrite(px + (py * m_Width), interpolatedZDepth))
+				{
+					++statistics.nrDepthTestsFailed;
+					if (pDepthFailCounts)
+						++pDepthFailCounts[px + (py * m_Width)];
+					continue;
+				}
+				++statistics.nrDepthTestsPassed;
 
 				switch (m_CurrentDisplayMode)
 				{
 				case DisplayMode::FinalColor:
+				case DisplayMode::RasterTime:
 				{
 					// When we want to interpolate vertex attributes with a correct depth(color, uv, normals, etc.),
 					// we still use the View Space depth(uses position.w)
@@ -1399,31 +1645,33 @@ void Renderer::RenderTriangleListW3(Mesh& mesh) const
 						(vOut2.uv / vOut2.position.w) * weightV2) * interpolatedWDepth
 					};
 
-					finalColor = m_pTukTukTexture->Sample(interpolatedUV);
+					++statistics.nrPixelShaderInvocations;
+					const Texture* pDiffuseMap = material.diffuse.Get();
+					finalColor = pDiffuseMap ? pDiffuseMap->Sample(interpolatedUV) : colors::White;
 					break;
 				}
 				case DisplayMode::DepthBuffer:
-				{
-					const float depthBufferColor = Remap(m_pDepthBufferPixels[px + (py * m_Width)], 0.985f, 1.0f);
-
-					finalColor = { depthBufferColor, depthBufferColor, depthBufferColor };
-					break;
-				}
+				case DisplayMode::Overdraw:
+				case DisplayMode::DepthFailures:
+					// only the depth is written, the whole buffer is visualized at once, see ResolveDepthView and ResolveHeatmap
+					continue;
 				}
 
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
+
+		if (isTimingBlocks)
+			AddHeatmapTime(left - offSet, bottom - offSet, right + offSet - 1, top + offSet - 1, Profiler::ReadTimestamp() - rasterStart);
 	}
+
+	m_Statistics += statistics;
 }
 
-void Renderer::RenderTriangleStripW3(const Mesh& mesh) const
+void Renderer::RenderTriangleStripW3(const Mesh& mesh, const MaterialTextures& material) const
 {
 	ColorRGB finalColor{};
 
@@ -1471,6 +1719,8 @@ void Renderer::RenderTriangleStripW3(const Mesh& mesh) const
 		if (bottom <= 1 || top >= (m_Height - 1))
 			continue;
 
+		m_pRenderTarget->ClearRegion(left, bottom, right - 1, top - 1);
+
 		for (INT px = left; px < right; ++px)
 		{
 			for (INT py = bottom; py < top; ++py)
@@ -1516,11 +1766,9 @@ void Renderer::RenderTriangleStripW3(const Mesh& mesh) const
 				if (interpolatedZDepthWeight < 0 || interpolatedZDepthWeight > 1)
 					continue;
 
-				if (interpolatedZDepthWeight > m_pDepthBufferPixels[px + (py * m_Width)])
+				if (!m_DepthBuffer.TestAndWrite(px + (py * m_Width), interpolatedZDepthWeight))
 					continue;
 
-				m_pDepthBufferPixels[px + (py * m_Width)] = interpolatedZDepthWeight;
-
 				switch (m_CurrentDisplayMode)
 				{
 				case DisplayMode::FinalColor:
@@ -1540,228 +1788,466 @@ void Renderer::RenderTriangleStripW3(const Mesh& mesh) const
 						(uvV2 / wV2) * weightV2) * interpolatedWDepthWeight
 					};
 
-					finalColor = m_pTukTukTexture->Sample(interpolatedUV);
+					const Texture* pDiffuseMap = material.diffuse.Get();
+					finalColor = pDiffuseMap ? pDiffuseMap->Sample(interpolatedUV) : colors::White;
 					break;
 				}
 				case DisplayMode::DepthBuffer:
 				{
-					const float depthBufferColor = Remap(m_pDepthBufferPixels[px + (py * m_Width)], 0.985f, 1.0f);
+					const float depthBufferColor = Remap(GetViewDepth(m_DepthBuffer.Read(px + (py * m_Width))), 0.985f, 1.0f);
 
 					finalColor = { depthBufferColor, depthBufferColor, depthBufferColor };
 					break;
 				}
+				default:
+					// the heatmaps are only counted for triangle lists
+					break;
 				}
 
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
 }
 #pragma endregion
 #pragma region Week4
-void Renderer::Render_W4() const
+void Renderer::Render_W4()
 {
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	{
+		ProfileScope clearScope{ ProfileStage::Clear };
 
-	ClearBackground();
+		// tiles are cleared when the first triangle touches them
+		m_pRenderTarget->BeginFrame(m_BackgroundColor, m_DepthBuffer.GetFarDepth());
+	}
 
-	std::vector<Mesh> meshes_world{ m_VehicleMesh };
+	ResetHeatmap();
 
-	VertexTransformationFunction_W4(meshes_world);
+	{
+		ProfileScope vertexScope{ ProfileStage::VertexTransform };
+
+		VertexTransformationFunction_W4(m_VehicleMesh);
+	}
 
-	for (auto& m : meshes_world)
 	{
+		ProfileScope rasterScope{ ProfileStage::Raster };
+
 		switch (m_VehicleMesh.primitiveTopology)
 		{
 		case PrimitiveTopology::TriangleList:
-			RenderTriangleListW4(m);
+			for (const SubMesh& subMesh : m_VehicleMesh.subMeshes)
+				RenderTriangleListW4(m_VehicleMesh, subMesh, GetMaterialTextures(subMesh.materialIndex));
 			break;
 		case PrimitiveTopology::TriangleStrip:
-			RenderTriangleStripW4(m);
+			RenderTriangleStripW4(m_VehicleMesh, GetMaterialTextures(m_VehicleMesh.subMeshes.empty() ? SubMesh::NoMaterial : m_VehicleMesh.subMeshes[0].materialIndex));
 			break;
 		}
 	}
+
+	// triangle strips still write the depth colors per pixel
+	if (m_CurrentDisplayMode == DisplayMode::DepthBuffer && m_VehicleMesh.primitiveTopology == PrimitiveTopology::TriangleList)
+	{
+		ProfileScope shadingScope{ ProfileStage::Shading };
+		ResolveDepthView(0.995f);
+	}
+
+	{
+		ProfileScope clearScope{ ProfileStage::Clear };
+		m_pRenderTarget->ResolveUntouchedTiles();
+	}
+
+	// covers the whole target, the background included
+	ProfileScope shadingScope{ ProfileStage::Shading };
+	ResolveHeatmap();
 }
 
-void Renderer::RenderTriangleListW4(Mesh& mesh) const
+void Renderer::RenderTriangleListW4(const Mesh& mesh, const SubMesh& subMesh, const MaterialTextures& material) const
 {
 	ColorRGB finalColor{ };
+	PipelineStatistics statistics{};
+
+	// only the heatmap that's displayed is filled in
+	uint32_t* const pOverdrawCounts = m_CurrentDisplayMode == DisplayMode::Overdraw ? m_HeatmapCounts.data() : nullptr;
+	uint32_t* const pDepthFailCounts = m_CurrentDisplayMode == DisplayMode::DepthFailures ? m_HeatmapCounts.data() : nullptr;
+	const bool isTimingBlocks = m_CurrentDisplayMode == DisplayMode::RasterTime;
 
-	for (size_t i{}; i < mesh.indices.size(); i += 3)
+	// per triangle and per pixel stages are summed up and recorded once the list is done
+	NestedStageTimer stageTimer{};
+
+	for (size_t i{ subMesh.indexOffset }; i < size_t(subMesh.indexOffset) + subMesh.indexCount; i += 3)
 	{
-		Vertex_Out vOut0 = mesh.vertices_out[mesh.indices[i]];
-		Vertex_Out vOut1 = mesh.vertices_out[mesh.indices[i + 1]];
-		Vertex_Out vOut2 = mesh.vertices_out[mesh.indices[i + 2]];
+		stageTimer.Restart();
 
-		// frustum culling check
-		if (!IsInFrustum(vOut0)
-			|| !IsInFrustum(vOut1)
-			|| !IsInFrustum(vOut2))
+		++statistics.nrInputTriangles;
+
+		const uint32_t index0 = mesh.indices[i];
+		const uint32_t index1 = mesh.indices[i + 1];
+		const uint32_t index2 = mesh.indices[i + 2];
+
+		// culled on the position stream, only the triangles that are kept load their attributes
+		const Vector4 position0 = mesh.positions_out.GetPoint(index0);
+		const Vector4 position1 = mesh.positions_out.GetPoint(index1);
+		const Vector4 position2 = mesh.positions_out.GetPoint(index2);
+
+		// frustum culling check, triangles that are partly inside are cut by the bounding box and the depth test
+		if (IsOutsideFrustum(position0, position1, position2))
+		{
+			++statistics.nrFrustumCulledTriangles;
+			stageTimer.Lap(ProfileStage::ClipCull);
 			continue;
+		}
+
+		Vertex_Out vOut0 = mesh.vertices_out[index0];
+		Vertex_Out vOut1 = mesh.vertices_out[index1];
+		Vertex_Out vOut2 = mesh.vertices_out[index2];
+		vOut0.position = position0;
+		vOut1.position = position1;
+		vOut2.position = position2;
 
 		// from NDC space to Raster space
 		NDCToRaster(vOut0);
 		NDCToRaster(vOut1);
 		NDCToRaster(vOut2);
 
-		const Vector2 v0 = { vOut0.position.x, vOut0.position.y };
-		const Vector2 v1 = { vOut1.position.x, vOut1.position.y };
-		const Vector2 v2 = { vOut2.position.x, vOut2.position.y };
+		// a vertex close to the camera plane lands far outside the screen, without clipping it can't be snapped
+		if (!IsInGuardBand(vOut0)
+			|| !IsInGuardBand(vOut1)
+			|| !IsInGuardBand(vOut2))
+		{
+			++statistics.nrFrustumCulledTriangles;
+			stageTimer.Lap(ProfileStage::ClipCull);
+			continue;
+		}
 
-		const Vector2 edge01 = v1 - v0;
-		const Vector2 edge12 = v2 - v1;
-		const Vector2 edge20 = v0 - v2;
+		stageTimer.Lap(ProfileStage::ClipCull);
 
-		const float areaTriangle = Vector2::Cross(edge01, edge12);
+		// 24.8 fixed point, coverage is decided on these exact positions
+		const Int2 fixed0{ ToFixed(vOut0.position.x), ToFixed(vOut0.position.y) };
+		const Int2 fixed1{ ToFixed(vOut1.position.x), ToFixed(vOut1.position.y) };
+		const Int2 fixed2{ ToFixed(vOut2.position.x), ToFixed(vOut2.position.y) };
 
-		// create bounding box for triangle
-		const INT top = std::max((INT)std::max(v0.y, v1.y), (INT)v2.y);
-		const INT bottom = std::min((INT)std::min(v0.y, v1.y), (INT)v2.y);
-
-		const INT left = std::min((INT)std::min(v0.x, v1.x), (INT)v2.x);
-		const INT right = std::max((INT)std::max(v0.x, v1.x), (INT)v2.x);
+		// twice the area in 16.16 fixed point, it needs 64 bits
+		const int64_t fixedArea = (int64_t(fixed1.x) - fixed0.x) * (int64_t(fixed2.y) - fixed0.y)
+			- (int64_t(fixed1.y) - fixed0.y) * (int64_t(fixed2.x) - fixed0.x);
 
-		// check if bounding box is in screen
-		if (left <= 0 || right >= m_Width - 1)
+		// pixels are only inside when all edge functions are positive, that can't happen for a negative area
+		if (fixedArea <= 0)
+		{
+			++statistics.nrBackFaceCulledTriangles;
 			continue;
+		}
 
-		if (bottom <= 0 || top >= m_Height - 1)
-			continue;
+		// the attributes are interpolated from the same snapped positions
+		vOut0.position.x = float(fixed0.x) / SubpixelScale;
+		vOut0.position.y = float(fixed0.y) / SubpixelScale;
+		vOut1.position.x = float(fixed1.x) / SubpixelScale;
+		vOut1.position.y = float(fixed1.y) / SubpixelScale;
+		vOut2.position.x = float(fixed2.x) / SubpixelScale;
+		vOut2.position.y = float(fixed2.y) / SubpixelScale;
 
-		constexpr INT offSet{ 1 };
+		const Vector2 v0 = { vOut0.position.x, vOut0.position.y };
 
-		// iterate over every pixel in the bounding box, with an offset we enlarge the BB
-		// in case of overlooked pixels
-		for (INT px = left - offSet; px < right + offSet; ++px)
+		// bounding box of the pixels whose sample point, at the whole pixel position, can be covered
+		const INT left = std::max((std::min(std::min(fixed0.x, fixed1.x), fixed2.x) + SubpixelScale - 1) >> SubpixelBits, 0);
+		const INT right = std::min(std::max(std::max(fixed0.x, fixed1.x), fixed2.x) >> SubpixelBits, m_Width - 1);
+		const INT bottom = std::max((std::min(std::min(fixed0.y, fixed1.y), fixed2.y) + SubpixelScale - 1) >> SubpixelBits, 0);
+		const INT top = std::min(std::max(std::max(fixed0.y, fixed1.y), fixed2.y) >> SubpixelBits, m_Height - 1);
+
+		stageTimer.Lap(ProfileStage::Setup);
+
+		// falls between the sample points or, at the border, outside the screen
+		if (left > right || bottom > top)
 		{
-			for (INT py = bottom - offSet; py < top + offSet; ++py)
-			{
-				finalColor = colors::Black;
+			++statistics.nrOffScreenTriangles;
+			continue;
+		}
 
-				Vector2 pixelPos = { (float)px,(float)py };
+		// the divisions by w happen here once, per pixel only the planes are evaluated
+		const TriangleSetup setup{ vOut0, vOut1, vOut2, float(fixedArea) / (SubpixelScale * SubpixelScale) };
 
-				const Vector2 directionV0 = pixelPos - v0;
-				const Vector2 directionV1 = pixelPos - v1;
-				const Vector2 directionV2 = pixelPos - v2;
+		const EdgeFunction edge01{ fixed0, fixed1 };
+		const EdgeFunction edge12{ fixed1, fixed2 };
+		const EdgeFunction edge20{ fixed2, fixed0 };
 
-				// weights are all negative => back-face culling
-				// vs all positive => front-face culling
-				float weightV2 = Vector2::Cross(edge01, directionV0);
-				if (weightV2 < 0)
-					continue;
+		stageTimer.Lap(ProfileStage::Setup);
 
-				float weightV0 = Vector2::Cross(edge12, directionV1);
-				if (weightV0 < 0)
-					continue;
+		m_pRenderTarget->ClearRegion(left, bottom, right, top);
 
-				float weightV1 = Vector2::Cross(edge20, directionV2);
-				if (weightV1 < 0)
-					continue;
+		stageTimer.Lap(ProfileStage::Clear);
 
-				weightV0 /= areaTriangle;
-				weightV1 /= areaTriangle;
-				weightV2 /= areaTriangle;
+		// the bounding box in blocks on a grid first. Blocks outside an edge are skipped, the pixels of blocks
+		// inside all edges are not tested. Only blocks an edge crosses are tested per pixel
+		for (INT blockY = bottom - bottom % RasterBlockSize; blockY <= top; blockY += RasterBlockSize)
+		{
+			const INT blockBottom = std::max(blockY, bottom);
+			const INT blockTop = std::min(blockY + RasterBlockSize - 1, top);
 
-				if (weightV0 + weightV1 + weightV2 < 1 - FLT_EPSILON
-					&& weightV0 + weightV1 + weightV2 > 1 + FLT_EPSILON)
-					continue;
+			for (INT blockX = left - left % RasterBlockSize; blockX <= right; blockX += RasterBlockSize)
+			{
+				const INT blockLeft = std::max(blockX, left);
+				const INT blockRight = std::min(blockX + RasterBlockSize - 1, right);
 
-				// This Z-BufferValue is the one we compare in the Depth Test and
-				// the value we store in the Depth Buffer (uses position.z).
-				float interpolatedZDepth = {
-					1.f /
-					((1 / vOut0.position.z) * weightV0 +
-					(1 / vOut1.position.z) * weightV1 +
-					(1 / vOut2.position.z) * weightV2)
-				};
+				// a skipped block only costs its edge tests
+				const uint64_t blockStart = isTimingBlocks ? Profiler::ReadTimestamp() : 0;
 
-				if (interpolatedZDepth < 0 || interpolatedZDepth > 1)
+				if (edge01.GetMax(blockLeft, blockBottom, blockRight, blockTop) < 0
+					|| edge12.GetMax(blockLeft, blockBottom, blockRight, blockTop) < 0
+					|| edge20.GetMax(blockLeft, blockBottom, blockRight, blockTop) < 0)
+				{
+					if (isTimingBlocks)
+						AddHeatmapBlockTime(blockX, blockY, Profiler::ReadTimestamp() - blockStart);
 					continue;
+				}
 
-				if (interpolatedZDepth > m_pDepthBufferPixels[px + (py * m_Width)])
-					continue;
+				const bool isBlockCovered = edge01.GetMin(blockLeft, blockBottom, blockRight, blockTop) >= 0
+					&& edge12.GetMin(blockLeft, blockBottom, blockRight, blockTop) >= 0
+					&& edge20.GetMin(blockLeft, blockBottom, blockRight, blockTop) >= 0;
 
-				m_pDepthBufferPixels[px + (py * m_Width)] = interpolatedZDepth;
+				const uint64_t nrBlockPixels{ uint64_t(blockRight - blockLeft + 1) * uint64_t(blockTop - blockBottom + 1) };
+				if (isBlockCovered)
+					statistics.nrPixelsAccepted += nrBlockPixels;
+				else
+					statistics.nrPixelsTested += nrBlockPixels;
 
-				switch (m_CurrentDisplayMode)
-				{
-				case DisplayMode::FinalColor:
+				// row by row, the edge functions are stepped to the next pixel. They are named after
+				// the vertex they weigh, like the barycentric weights
+				for (INT py = blockBottom; py <= blockTop; ++py)
 				{
-					// When we want to interpolate vertex attributes with a correct depth(color, uv, normals, etc.),
-					// we still use the View Space depth(uses position.w)
-					const float interpolatedWDepth = {
-						1.f /
-						((1 / vOut0.position.w) * weightV0 +
-						(1 / vOut1.position.w) * weightV1 +
-						(1 / vOut2.position.w) * weightV2)
-					};
-
-					const Vector2 interpolatedUV = {
-						((vOut0.uv / vOut0.position.w) * weightV0 +
-						(vOut1.uv / vOut1.position.w) * weightV1 +
-						(vOut2.uv / vOut2.position.w) * weightV2) * interpolatedWDepth
-					};
+					int64_t weightV0 = edge12.Evaluate(blockLeft, py);
+					int64_t weightV1 = edge20.Evaluate(blockLeft, py);
+					int64_t weightV2 = edge01.Evaluate(blockLeft, py);
 
-					const Vector3 interpolatedNormal = {
-						((vOut0.normal / vOut0.position.w) * weightV0 +
-						(vOut1.normal / vOut1.position.w) * weightV1 +
-						(vOut2.normal / vOut2.position.w) * weightV2) * interpolatedWDepth
-					};
+					for (INT px = blockLeft; px <= blockRight; ++px, weightV0 += edge12.stepX, weightV1 += edge20.stepX, weightV2 += edge01.stepX)
+					{
+						// any negative weight has its sign bit set
+						if (!isBlockCovered && (weightV0 | weightV1 | weightV2) < 0)
+							continue;
+
+						finalColor = colors::Black;
+
+						const Vector2 pixelPos = { (float)px,(float)py };
+						const Vector2 directionV0 = pixelPos - v0;
+
+						++statistics.nrPixelsCovered;
+
+						// This Z-BufferValue is the one we compare in the Depth Test and
+						// the value we store in the Depth Buffer (uses position.z).
+						// NDC depth is linear in screen space, unlike the attributes below. The weighted
+						// harmonic mean used before was close enough near 1, but not for reversed-Z near 0
+						const float interpolatedZDepth = setup.depth.Evaluate(directionV0);
+
+						if (interpolatedZDepth < 0 || interpolatedZDepth > 1)
+							continue;
+
+						if (pOverdrawCounts)
+							++pOverdrawCounts[px + (py * m_Width)];
+
+						if (!m_DepthBuffer.TestAndWrite(px + (py * m_Width), interpolatedZDepth))
+						{
+							++statistics.nrDepthTestsFailed;
+							if (pDepthFailCounts)
+								++pDepthFailCounts[px + (py * m_Width)];
+							continue;
+						}
+						++statistics.nrDepthTestsPassed;
+
+						switch (m_CurrentDisplayMode)
+						{
+						case DisplayMode::FinalColor:
+						case DisplayMode::RasterTime:
+						{
+							// When we want to interpolate vertex attributes with a correct depth(color, uv, normals, etc.),
+							// we still use the View Space depth(uses position.w)
+							const float interpolatedWDepth = 1.f / setup.invW.Evaluate(directionV0);
+
+							const Vector2 interpolatedUV = setup.uv.Evaluate(directionV0) * interpolatedWDepth;
+							const Vector3 interpolatedNormal = setup.normal.Evaluate(directionV0) * interpolatedWDepth;
+							const Vector3 interpolatedTangent = setup.tangent.Evaluate(directionV0) * interpolatedWDepth;
+							const Vector3 interpolatedViewDirection = setup.viewDirection.Evaluate(directionV0) * interpolatedWDepth;
+
+							//Interpolated Vertex Attributes for Pixel
+							Vertex_Out pixel;
+							pixel.position = { pixelPos.x, pixelPos.y, interpolatedZDepth, interpolatedWDepth };
+							pixel.color = finalColor;
+							pixel.uv = interpolatedUV;
+							pixel.normal = interpolatedNormal;
+							pixel.tangent = interpolatedTangent;
+							pixel.viewDirection = interpolatedViewDirection;
+
+							++statistics.nrPixelShaderInvocations;
+							stageTimer.Restart();
+							PixelShading(pixel, material);
+							stageTimer.Lap(ProfileStage::Shading);
+
+							finalColor = pixel.color;
+
+							break;
+						}
+						case DisplayMode::DepthBuffer:
+						case DisplayMode::Overdraw:
+						case DisplayMode::DepthFailures:
+							// only the depth is written, the whole buffer is visualized at once, see ResolveDepthView and ResolveHeatmap
+							continue;
+						}
+
+						//Update Color in Buffer
+						finalColor.MaxToOne();
+
+						m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
+					}
+				}
 
-					const Vector3 interpolatedTangent = {
-						((vOut0.tangent / vOut0.position.w) * weightV0 +
-						(vOut1.tangent / vOut1.position.w) * weightV1 +
-						(vOut2.tangent / vOut2.position.w) * weightV2) * interpolatedWDepth
-					};
+				if (isTimingBlocks)
+					AddHeatmapBlockTime(blockX, blockY, Profiler::ReadTimestamp() - blockStart);
+			}
+		}
+	}
 
-					const Vector3 interpolatedViewDirection = {
-						((vOut0.viewDirection / vOut0.position.w) * weightV0 +
-						(vOut1.viewDirection / vOut1.position.w) * weightV1 +
-						(vOut2.viewDirection / vOut2.position.w) * weightV2) * interpolatedWDepth
-					};
-					
-					//Interpolated Vertex Attributes for Pixel
-					Vertex_Out pixel;
-					pixel.position = { pixelPos.x, pixelPos.y, interpolatedZDepth, interpolatedWDepth };
-					pixel.color = finalColor;
-					pixel.uv = interpolatedUV;
-					pixel.normal = interpolatedNormal;
-					pixel.tangent = interpolatedTangent;
-					pixel.viewDirection = interpolatedViewDirection;
+	m_Statistics += statistics;
+}
 
-					PixelShading(pixel);
+void Renderer::ResolveDepthView(float minDepth) const
+{
+	// every covered pixel becomes a gray value for its final depth, the background stays untouched.
+	// Runs before RenderTarget::ResolveUntouchedTiles
+	m_ThreadPool.ParallelFor(size_t(m_Height), [this, minDepth](size_t begin, size_t end)
+		{
+			std::vector<ColorRGB> colors(m_Width);
+			const float farDepth = m_DepthBuffer.GetFarDepth();
 
-					finalColor = pixel.color;
+			for (size_t py = begin; py < end; ++py)
+			{
+				const size_t rowStart = py * m_Width;
+				uint32_t* pColorRow = m_pBackBufferPixels + py * m_Width;
 
-					break;
-				}
-				case DisplayMode::DepthBuffer:
+				const int tileY = int(py) / RenderTarget::TileSize;
+				for (int tileX{}; tileX < m_pRenderTarget->GetNrTilesX(); ++tileX)
 				{
-					const float depthBufferColor = Remap(m_pDepthBufferPixels[px + (py * m_Width)], 0.995f, 1.0f);
-					
-					finalColor = { depthBufferColor, depthBufferColor, depthBufferColor };
-					break;
-				}
-				}
+					// the depth of tiles nothing was drawn to isn't cleared
+					if (!m_pRenderTarget->IsTileCleared(tileX, tileY))
+						continue;
 
-				//Update Color in Buffer
-				finalColor.MaxToOne();
+					const int tileEnd = std::min((tileX + 1) * RenderTarget::TileSize, m_Width);
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+					// pack every run of covered pixels in one go
+					int px{ tileX * RenderTarget::TileSize };
+					while (px < tileEnd)
+					{
+						while (px < tileEnd && m_DepthBuffer.Read(rowStart + px) == farDepth)
+							++px;
+
+						const int runStart = px;
+						float depth{};
+						for (; px < tileEnd && (depth = m_DepthBuffer.Read(rowStart + px)) != farDepth; ++px)
+						{
+							const float depthBufferColor = Remap(GetViewDepth(depth), minDepth, 1.0f);
+							colors[px] = { depthBufferColor, depthBufferColor, depthBufferColor };
+						}
+
+						PackColors(colors.data() + runStart, pColorRow + runStart, size_t(px - runStart), m_PixelLayout);
+					}
+				}
 			}
+		}, 16);
+}
+
+void Renderer::ResetHeatmap() const
+{
+	switch (m_CurrentDisplayMode)
+	{
+	case DisplayMode::Overdraw:
+	case DisplayMode::DepthFailures:
+		m_HeatmapCounts.assign(size_t(m_Width) * m_Height, 0);
+		break;
+	case DisplayMode::RasterTime:
+		m_HeatmapBlockTicks.assign(size_t(GetNrHeatmapBlocksX()) * ((m_Height + HeatmapBlockSize - 1) / HeatmapBlockSize), 0);
+		break;
+	default:
+		break;
+	}
+}
+
+void Renderer::AddHeatmapTime(int left, int bottom, int right, int top, uint64_t ticks) const
+{
+	// spread over the blocks by how much of the bounding box they hold
+	const double ticksPerPixel = double(ticks) / (double(right - left + 1) * double(top - bottom + 1));
+	const int nrBlocksX = GetNrHeatmapBlocksX();
+
+	for (int blockY = bottom / HeatmapBlockSize; blockY <= top / HeatmapBlockSize; ++blockY)
+	{
+		const int nrRows = std::min(top, (blockY + 1) * HeatmapBlockSize - 1) - std::max(bottom, blockY * HeatmapBlockSize) + 1;
+
+		for (int blockX = left / HeatmapBlockSize; blockX <= right / HeatmapBlockSize; ++blockX)
+		{
+			const int nrColumns = std::min(right, (blockX + 1) * HeatmapBlockSize - 1) - std::max(left, blockX * HeatmapBlockSize) + 1;
+			m_HeatmapBlockTicks[size_t(blockY) * nrBlocksX + blockX] += uint64_t(ticksPerPixel * nrRows * nrColumns);
 		}
 	}
 }
 
+void Renderer::AddHeatmapBlockTime(int x, int y, uint64_t ticks) const
+{
+	static_assert(HeatmapBlockSize % RasterBlockSize == 0, "a raster block has to fall in a single heatmap block");
+	m_HeatmapBlockTicks[size_t(y / HeatmapBlockSize) * GetNrHeatmapBlocksX() + x / HeatmapBlockSize] += ticks;
+}
+
+void Renderer::ResolveHeatmap() const
+{
+	// counts are red from this many fragments per pixel on, times are relative to the slowest block
+	constexpr float MaxHeatmapCount{ 8.f };
+
+	float scale{};
+	switch (m_CurrentDisplayMode)
+	{
+	case DisplayMode::Overdraw:
+	case DisplayMode::DepthFailures:
+		scale = 1.f / MaxHeatmapCount;
+		break;
+	case DisplayMode::RasterTime:
+		scale = 1.f / float(std::max(*std::max_element(m_HeatmapBlockTicks.begin(), m_HeatmapBlockTicks.end()), uint64_t(1)));
+		break;
+	default:
+		return;
+	}
+
+	const bool isTimingBlocks = m_CurrentDisplayMode == DisplayMode::RasterTime;
+	m_ThreadPool.ParallelFor(size_t(m_Height), [this, scale, isTimingBlocks](size_t begin, size_t end)
+		{
+			std::vector<ColorRGB> colors(m_Width);
+			const int nrBlocksX = GetNrHeatmapBlocksX();
+
+			for (size_t py = begin; py < end; ++py)
+			{
+				const uint64_t* pBlockRow = isTimingBlocks ? m_HeatmapBlockTicks.data() + (py / HeatmapBlockSize) * nrBlocksX : nullptr;
+				const uint32_t* pCountRow = isTimingBlocks ? nullptr : m_HeatmapCounts.data() + py * m_Width;
+
+				for (int px{}; px < m_Width; ++px)
+				{
+					const float value = isTimingBlocks ? float(pBlockRow[px / HeatmapBlockSize]) : float(pCountRow[px]);
+					colors[px] = GetHeatmapColor(value * scale);
+				}
+
+				PackColors(colors.data(), m_pBackBufferPixels + py * m_Width, size_t(m_Width), m_PixelLayout);
+			}
+		}, 16);
+}
+
+ColorRGB Renderer::GetHeatmapColor(float value)
+{
+	// black when nothing happened, then from blue over green and yellow to red
+	if (value <= 0.f)
+		return colors::Black;
+
+	const float t = std::min(value, 1.f) * 3.f;
+	if (t < 1.f)
+		return { 0.f, t, 1.f - t };
+	if (t < 2.f)
+		return { t - 1.f, 1.f, 0.f };
+	return { 1.f, 3.f - t, 0.f };
+}
+
 void Renderer::DepthRemap(float& depth, float topPercentile) const
 {
 	depth = (depth - (1.f - topPercentile)) / topPercentile;
@@ -1770,7 +2256,7 @@ void Renderer::DepthRemap(float& depth, float topPercentile) const
 	depth = std::min(1.f, depth);
 }
 
-void Renderer::RenderTriangleStripW4(const Mesh& mesh) const
+void Renderer::RenderTriangleStripW4(const Mesh& mesh, const MaterialTextures& material) const
 {
 	ColorRGB finalColor{};
 
@@ -1784,17 +2270,21 @@ void Renderer::RenderTriangleStripW4(const Mesh& mesh) const
 		const int vIdx1{ (int)mesh.indices[(int)i + 1 * !isOdd + 2 * isOdd] };
 		const int vIdx2{ (int)mesh.indices[(int)i + 2 * !isOdd + 1 * isOdd] };
 
-		const Vector2 v0 = { mesh.vertices_out[mesh.indices[vIdx0]].position.x, mesh.vertices_out[mesh.indices[vIdx0]].position.y };
-		const Vector2 v1 = { mesh.vertices_out[mesh.indices[vIdx1]].position.x, mesh.vertices_out[mesh.indices[vIdx1]].position.y };
-		const Vector2 v2 = { mesh.vertices_out[mesh.indices[vIdx2]].position.x, mesh.vertices_out[mesh.indices[vIdx2]].position.y };
+		const Vector4 positionV0 = mesh.positions_out.GetPoint(mesh.indices[vIdx0]);
+		const Vector4 positionV1 = mesh.positions_out.GetPoint(mesh.indices[vIdx1]);
+		const Vector4 positionV2 = mesh.positions_out.GetPoint(mesh.indices[vIdx2]);
 
-		const float depthV0 = mesh.vertices_out[mesh.indices[vIdx0]].position.z;
-		const float depthV1 = mesh.vertices_out[mesh.indices[vIdx1]].position.z;
-		const float depthV2 = mesh.vertices_out[mesh.indices[vIdx2]].position.z;
+		const Vector2 v0 = positionV0.GetXY();
+		const Vector2 v1 = positionV1.GetXY();
+		const Vector2 v2 = positionV2.GetXY();
 
-		const float wV0 = mesh.vertices_out[mesh.indices[vIdx0]].position.w;
-		const float wV1 = mesh.vertices_out[mesh.indices[vIdx1]].position.w;
-		const float wV2 = mesh.vertices_out[mesh.indices[vIdx2]].position.w;
+		const float depthV0 = positionV0.z;
+		const float depthV1 = positionV1.z;
+		const float depthV2 = positionV2.z;
+
+		const float wV0 = positionV0.w;
+		const float wV1 = positionV1.w;
+		const float wV2 = positionV2.w;
 
 		const Vector2 uvV0 = mesh.vertices_out[mesh.indices[vIdx0]].uv;
 		const Vector2 uvV1 = mesh.vertices_out[mesh.indices[vIdx1]].uv;
@@ -1818,6 +2308,8 @@ void Renderer::RenderTriangleStripW4(const Mesh& mesh) const
 		if (bottom <= 1 || top >= (m_Height - 1))
 			continue;
 
+		m_pRenderTarget->ClearRegion(left, bottom, right - 1, top - 1);
+
 		for (INT px = left; px < right; ++px)
 		{
 			for (INT py = bottom; py < top; ++py)
@@ -1863,11 +2355,9 @@ void Renderer::RenderTriangleStripW4(const Mesh& mesh) const
 				if (interpolatedZDepthWeight < 0 || interpolatedZDepthWeight > 1)
 					continue;
 
-				if (interpolatedZDepthWeight > m_pDepthBufferPixels[px + (py * m_Width)])
+				if (!m_DepthBuffer.TestAndWrite(px + (py * m_Width), interpolatedZDepthWeight))
 					continue;
 
-				m_pDepthBufferPixels[px + (py * m_Width)] = interpolatedZDepthWeight;
-
 				switch (m_CurrentDisplayMode)
 				{
 				case DisplayMode::FinalColor:
@@ -1887,25 +2377,26 @@ void Renderer::RenderTriangleStripW4(const Mesh& mesh) const
 						(uvV2 / wV2) * weightV2) * interpolatedWDepthWeight
 					};
 
-					finalColor = m_pTukTukTexture->Sample(interpolatedUV);
+					const Texture* pDiffuseMap = material.diffuse.Get();
+					finalColor = pDiffuseMap ? pDiffuseMap->Sample(interpolatedUV) : colors::White;
 					break;
 				}
 				case DisplayMode::DepthBuffer:
 				{
-					const float depthBufferColor = Remap(m_pDepthBufferPixels[px + (py * m_Width)], 0.985f, 1.0f);
+					const float depthBufferColor = Remap(GetViewDepth(m_DepthBuffer.Read(px + (py * m_Width))), 0.985f, 1.0f);
 
 					finalColor = { depthBufferColor, depthBufferColor, depthBufferColor };
 					break;
 				}
+				default:
+					// the heatmaps are only counted for triangle lists
+					break;
 				}
 
 				//Update Color in Buffer
 				finalColor.MaxToOne();
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				m_pBackBufferPixels[px + (py * m_Width)] = PackColor(finalColor, m_PixelLayout);
 			}
 		}
 	}
@@ -1925,15 +2416,40 @@ bool Renderer::IsInFrustum(const Vertex_Out& v) const
 	return true;
 }
 
+bool Renderer::IsOutsideFrustum(const Vector4& p0, const Vector4& p1, const Vector4& p2) const
+{
+	// there is no clipping, a vertex behind the camera would be projected mirrored
+	if (p0.w <= 0 || p1.w <= 0 || p2.w <= 0)
+		return true;
+
+	// all three vertices on the outer side of the same plane
+	if ((p0.x < -1 && p1.x < -1 && p2.x < -1) || (p0.x > 1 && p1.x > 1 && p2.x > 1))
+		return true;
+
+	if ((p0.y < -1 && p1.y < -1 && p2.y < -1) || (p0.y > 1 && p1.y > 1 && p2.y > 1))
+		return true;
+
+	if ((p0.z < 0 && p1.z < 0 && p2.z < 0) || (p0.z > 1 && p1.z > 1 && p2.z > 1))
+		return true;
+
+	return false;
+}
+
+bool Renderer::IsInGuardBand(const Vertex_Out& v) const
+{
+	return std::abs(v.position.x) <= MaxRasterCoordinate && std::abs(v.position.y) <= MaxRasterCoordinate;
+}
+
 void Renderer::NDCToRaster(Vertex_Out& v) const
 {
 	v.position.x = (v.position.x + 1) * 0.5f * (float)m_Width;
 	v.position.y = (1 - v.position.y) * 0.5f * (float)m_Height;
 }
 
-void Renderer::TukTukMeshInit()
+void Renderer::TukTukMeshInit(const std::string& meshPath)
 {
-	Utils::ParseOBJ("Resources/tuktuk.obj", m_TukTukMesh.vertices, m_TukTukMesh.indices);
+	// Streamed in on a background thread, see Update
+	m_MeshLoader.LoadAsync(meshPath.empty() ? "Resources/tuktuk.obj" : meshPath, &m_ThreadPool);
 
 	const Vector3 position{ m_Camera.origin + Vector3{ 0.0f, -3.0f, 15.0f } };
 	const Vector3 rotation{ 0,0,0 };
@@ -1943,9 +2459,10 @@ void Renderer::TukTukMeshInit()
 	m_TukTukMesh.primitiveTopology = PrimitiveTopology::TriangleList;
 }
 
-void Renderer::VehicleMeshInit()
+void Renderer::VehicleMeshInit(const std::string& meshPath)
 {
-	Utils::ParseOBJ("Resources/vehicle.obj", m_VehicleMesh.vertices, m_VehicleMesh.indices);
+	// Streamed in on a background thread, see Update
+	m_MeshLoader.LoadAsync(meshPath.empty() ? "Resources/vehicle.obj" : meshPath, &m_ThreadPool);
 
 	const Vector3 position{ m_Camera.origin + Vector3{ 0.0f, 0.0f, 50.f } };
 	const Vector3 rotation{ Vector3{0, 0, 0 } };
@@ -1955,6 +2472,26 @@ void Renderer::VehicleMeshInit()
 	m_VehicleMesh.primitiveTopology = PrimitiveTopology::TriangleList;
 }
 
+void Renderer::UpdateMaterialTextures(const Mesh& mesh)
+{
+	// materials are only ever appended, the cache shares textures between them
+	for (size_t i = m_MaterialTextures.size(); i < mesh.materials.size(); ++i)
+	{
+		const Material& material = mesh.materials[i];
+		const auto load = [this](const std::string& path) { return path.empty() ? TextureHandle{} : m_TextureCache.Load(path); };
+
+		m_MaterialTextures.push_back({ load(material.diffuseMap), load(material.normalMap), load(material.glossinessMap), load(material.specularMap) });
+	}
+}
+
+const Renderer::MaterialTextures& Renderer::GetMaterialTextures(uint32_t materialIndex) const
+{
+	if (materialIndex >= m_MaterialTextures.size())
+		return m_DefaultMaterialTextures;
+
+	return m_MaterialTextures[materialIndex];
+}
+
 void Renderer::SetFovAngle(const float newFovAngle)
 {
 	m_FovAngle = newFovAngle;
@@ -1971,20 +2508,58 @@ void Renderer::SetAspectRatio(const float newAspectRatio)
 
 void dae::Renderer::ClearBackground() const
 {
-	SDL_FillRect(m_pBackBuffer, nullptr, SDL_MapRGB(m_pBackBuffer->format, 100, 100, 100));
+	SDL_FillRect(m_pBackBuffer, nullptr, m_BackgroundColor);
+}
+
+bool Renderer::SaveBufferToImage(const std::string& path) const
+{
+	// never stall the frame on disk I/O, drop the screenshot when the writer is still busy
+	return !m_ScreenshotWriter.Submit(*m_pRenderTarget, path, false);
+}
+
+void Renderer::ToggleReversedZ()
+{
+	m_Camera.SetReversedZ(!m_Camera.isReversedZ);
+	SetRenderTarget(m_CurrentRenderTarget);
 }
 
-bool Renderer::SaveBufferToImage() const
+void Renderer::SetDepthFormat(DepthFormat depthFormat)
 {
-	return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
+	// the present thread only reads color, the depth buffers are free to swap
+	for (RenderTarget* pRenderTarget : m_RenderTargets)
+		pRenderTarget->SetDepthFormat(depthFormat);
+	SetRenderTarget(m_CurrentRenderTarget);
+}
+
+DepthFormat Renderer::GetDepthFormat() const
+{
+	return m_pRenderTarget->GetDepthFormat();
+}
+
+float Renderer::GetViewDepth(float depth) const
+{
+	// same picture for both depth conventions
+	return m_Camera.isReversedZ ? 1.f - depth : depth;
 }
 
 void Renderer::ToggleDisplayMode()
 {
-	m_CurrentDisplayMode = DisplayMode{ ((int)m_CurrentDisplayMode + 1) % 2 };
+	m_CurrentDisplayMode = DisplayMode{ ((int)m_CurrentDisplayMode + 1) % 5 };
+}
+
+const char* Renderer::GetDisplayModeName() const
+{
+	constexpr const char* displayModeNames[]{ "final color", "depth buffer", "overdraw", "depth test failures", "raster time" };
+	return displayModeNames[(int)m_CurrentDisplayMode];
 }
 
 void Renderer::ToggleShadingMode()
 {
 	m_CurrentShadingMode = ShadingMode{ ((int)m_CurrentShadingMode + 1) % 4 };
+}
+
+const char* Renderer::GetShadingModeName() const
+{
+	constexpr const char* shadingModeNames[]{ "observed area", "diffuse", "specular", "combined" };
+	return shadingModeNames[(int)m_CurrentShadingMode];
 }
\ No newline at end of file
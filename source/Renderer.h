@@ -1,26 +1,40 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "Camera.h"
 #include "DataTypes.h"
+#include "DepthBuffer.h"
+#include "FrameWriter.h"
+#include "MeshLoader.h"
+#include "PipelineStatistics.h"
+#include "PixelPacking.h"
+#include "Texture.h"
+#include "TextureCache.h"
+#include "ThreadPool.h"
 
 struct SDL_Window;
 struct SDL_Surface;
 
 namespace dae
 {
-	class Texture;
 	struct Mesh;
 	struct Vertex;
 	class Timer;
 	class Scene;
 
+	class RenderTarget;
+	class Presenter;
+
 	class Renderer final
 	{
 	public:
+		//Renders into rotating render targets, a present thread copies the finished ones to the window
 		Renderer(SDL_Window* pWindow);
+		//Headless, frames are only rendered into the render target. An empty meshPath loads the default scene
+		Renderer(int width, int height, const std::string& meshPath = {});
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -29,19 +43,64 @@ namespace dae
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
 		void Update(Timer* pTimer);
-		void Render() const;
+		void Render();
 
-		bool SaveBufferToImage() const;
+		//Queues the current frame to be written in the background, the format follows the extension.
+		//Returns true when the frame couldn't be queued
+		bool SaveBufferToImage(const std::string& path = "Rasterizer_ColorBuffer.bmp") const;
+		//Holds the last rendered frame until the next Render
+		const RenderTarget& GetRenderTarget() const { return *m_pRenderTarget; }
+		//Cycles final color, depth buffer and the overdraw, depth test failure and raster time heatmaps
 		void ToggleDisplayMode();
+		const char* GetDisplayModeName() const;
 		void ToggleMeshRotation() { m_IsRotating = !m_IsRotating; }
 		void ToggleNormalMap() { m_EnableNormalMap = !m_EnableNormalMap; }
 		void ToggleShadingMode();
+		const char* GetShadingModeName() const;
+		void ToggleReversedZ();
+		bool IsReversedZ() const { return m_Camera.isReversedZ; }
+		void SetDepthFormat(DepthFormat depthFormat);
+		DepthFormat GetDepthFormat() const;
+
+		//The window loop pauses presenting while it pumps events, SDL can recreate the window surface then.
+		//Resume hands the last rendered frame to the present thread
+		void PausePresenting();
+		void ResumePresenting();
+
+		//True while the mesh is still streaming in
+		bool IsLoading() const { return m_MeshLoader.IsLoading(); }
+		//The mesh couldn't be read, whatever streamed in before the error is still shown
+		bool HasLoadingFailed() const { return m_MeshLoader.HasFailed(); }
+		//Appends the streamed chunks without touching the camera, Update does this every frame
+		void PollLoading();
+		//Blocks until the whole mesh is loaded and appends it
+		void WaitForLoading();
+
+		//Changes the output size, e.g. when the window is resized. The render resolution follows it,
+		//scaled down when dynamic resolution is enabled. With a window presenting has to be paused
+		void Resize(int width, int height);
+		//Scales the render resolution every frame to keep the render time within targetFrameTime (seconds),
+		//the present thread upscales to the output size
+		void SetDynamicResolution(bool isEnabled, float targetFrameTime = 1.f / 60.f);
+		bool IsDynamicResolution() const { return m_IsDynamicResolution; }
+		float GetResolutionScale() const { return m_ResolutionScale; }
+
+		//Counted while rendering the last frame
+		const PipelineStatistics& GetStatistics() const { return m_Statistics; }
+
+		//Pitch and yaw in radians
+		void SetCameraTransform(const Vector3& origin, float pitch, float yaw) { m_Camera.SetTransform(origin, pitch, yaw); }
 
 	private:
 		enum class DisplayMode
 		{
 			FinalColor,
-			DepthBuffer
+			DepthBuffer,
+			// fragments that reached the depth test per pixel
+			Overdraw,
+			DepthFailures,
+			// rasterization and shading time per 16x16 block, the W4 list times every 8x8 block it visits
+			RasterTime
 		};
 
 		enum class ShadingMode
@@ -52,44 +111,107 @@ namespace dae
 			Combined
 		};
 
-		SDL_Window* m_pWindow{};
+		// With a window the frame being rendered, the one waiting to be presented and the one
+		// being presented each have their own target. Headless only needs one
+		static constexpr int NrWindowRenderTargets{ 3 };
+
+		Presenter* m_pPresenter{ nullptr };
+		// rendered but not submitted yet, see ResumePresenting
+		const RenderTarget* m_pFinishedTarget{ nullptr };
+		bool m_IsPresentingPaused{ false };
+
+		// owns the back and depth buffers, m_pRenderTarget is the one being rendered into
+		// and the pointers below point into it
+		std::vector<RenderTarget*> m_RenderTargets{};
+		size_t m_CurrentRenderTarget{};
+		RenderTarget* m_pRenderTarget{ nullptr };
 
-		SDL_Surface* m_pFrontBuffer{ nullptr };
 		SDL_Surface* m_pBackBuffer{ nullptr };
 		uint32_t* m_pBackBufferPixels{};
 
+		// only set for Float32 depth, the W1/W2 paths use it directly
 		float* m_pDepthBufferPixels{};
+		// W3/W4 depth test for any depth format
+		DepthBuffer m_DepthBuffer{};
+
+		// channel shifts of the back buffer format, pixels are packed directly
+		PixelLayout m_PixelLayout{};
+		uint32_t m_BackgroundColor{};
 
 		Camera m_Camera{};
 
+		// render resolution, the size of the render targets
 		int m_Width{};
 		int m_Height{};
+		// window or requested size
+		int m_OutputWidth{};
+		int m_OutputHeight{};
+
+		// the scale only moves in steps so the targets aren't reallocated every frame
+		static constexpr float ResolutionScaleStep{ 1.f / 16.f };
+		static constexpr float MinResolutionScale{ 4 * ResolutionScaleStep };
+		bool m_IsDynamicResolution{ false };
+		float m_TargetFrameTime{ 1.f / 60.f };
+		float m_ResolutionScale{ 1.f };
 		float m_AspectRatio{};
 		float m_FovAngle{};
 
-		Texture* m_pUVGridTexture;
-		Texture* m_pTukTukTexture;
+		// Textures of one mesh material, empty handles for maps it doesn't use
+		struct MaterialTextures
+		{
+			TextureHandle diffuse{};
+			TextureHandle normal{};
+			TextureHandle glossiness{};
+			TextureHandle specular{};
+		};
+
+		// Decoded in parallel on the pool, only waited on when first sampled
+		mutable ThreadPool m_ThreadPool{};
+		TextureCache m_TextureCache{ m_ThreadPool };
+
+		TextureHandle m_UVGridTexture;
 
-		Texture* m_pVehicleDiffuse;
-		Texture* m_pVehicleNormalMap;
-		Texture* m_pGlossinessMap;
-		Texture* m_pSpecularMap;
+		// One entry per material of the active mesh, in the same order
+		std::vector<MaterialTextures> m_MaterialTextures{};
+		MaterialTextures m_DefaultMaterialTextures{};
 
 		Mesh m_TukTukMesh;
 		Mesh m_VehicleMesh;
 
+		MeshLoader m_MeshLoader;
+		// Screenshots are encoded and written in the background
+		mutable FrameWriter m_ScreenshotWriter{ 2 };
+		// Reset at the start of every frame, the triangle lists add their counts when they're done
+		mutable PipelineStatistics m_Statistics{};
+
+		// triangle lists test their edges against blocks of this many pixels squared before single pixels
+		static constexpr int RasterBlockSize{ 8 };
+		// largest raster coordinate in pixels, in 24.8 fixed point the area of a triangle still fits in 64 bits
+		static constexpr float MaxRasterCoordinate{ 1 << 21 };
+
+		// per pixel counts or time stamp counter ticks per block of the heatmap display modes
+		static constexpr int HeatmapBlockSize{ 16 };
+		mutable std::vector<uint32_t> m_HeatmapCounts{};
+		mutable std::vector<uint64_t> m_HeatmapBlockTicks{};
+
 		DisplayMode m_CurrentDisplayMode;
 		ShadingMode m_CurrentShadingMode;
 		bool m_IsRotating;
 		bool m_EnableNormalMap;
 
+		void Initialize(int width, int height, int nrRenderTargets, const std::string& meshPath);
+		void SetRenderTarget(size_t index);
+		void SubmitFinishedTarget();
+		void SetRenderResolution(int width, int height);
+		void UpdateResolutionScale(float renderTime);
+
 		//Function that transforms the vertices from the mesh from World space to Screen space
 		void VertexTransformationFunction_W1(const std::vector<Vertex>& vertices_in, std::vector<Vertex>& vertices_out) const; //W1 Version
 		void VertexTransformationFunction_W2(const std::vector<Mesh>& meshes_in, std::vector<Mesh>& meshes_out) const;	//W2 Version
 		void VertexTransformationFunction_W3(std::vector<Mesh>& meshes) const;	//W3 Version
-		void VertexTransformationFunction_W4(std::vector<Mesh>& meshes) const;	//W4 Version
+		void VertexTransformationFunction_W4(Mesh& mesh) const;	//W4 Version
 
-		void PixelShading(Vertex_Out& v) const;
+		void PixelShading(Vertex_Out& v, const MaterialTextures& material) const;
 
 		void Render_W1_Part1() const;
 		void Render_W1_Part2() const;
@@ -103,18 +225,25 @@ namespace dae
 		void Render_W2_Part4() const;
 
 		void Render_W3() const;
-		void RenderTriangleListW3(Mesh& mesh) const;
-		void RenderTriangleStripW3(const Mesh& mesh) const;
+		void RenderTriangleListW3(Mesh& mesh, const SubMesh& subMesh, const MaterialTextures& material) const;
+		void RenderTriangleStripW3(const Mesh& mesh, const MaterialTextures& material) const;
 
-		void Render_W4() const;
-		void RenderTriangleListW4(Mesh& mesh) const;
-		void RenderTriangleStripW4(const Mesh& mesh) const;
+		void Render_W4();
+		void RenderTriangleListW4(const Mesh& mesh, const SubMesh& subMesh, const MaterialTextures& material) const;
+		void RenderTriangleStripW4(const Mesh& mesh, const MaterialTextures& material) const;
 
 		bool IsInFrustum(const Vertex_Out& v) const;
+		//True when the triangle can't cover a pixel in depth range. Triangles across the border of the
+		//screen or the depth range are kept, the bounding box and the depth test cut those
+		bool IsOutsideFrustum(const Vector4& p0, const Vector4& p1, const Vector4& p2) const;
+		//Raster positions are only converted to fixed point this far outside the screen, see RenderTriangleListW4
+		bool IsInGuardBand(const Vertex_Out& v) const;
 		void NDCToRaster(Vertex_Out& v) const;
 
-		void TukTukMeshInit();
-		void VehicleMeshInit();
+		void TukTukMeshInit(const std::string& meshPath);
+		void VehicleMeshInit(const std::string& meshPath);
+		void UpdateMaterialTextures(const Mesh& mesh);
+		const MaterialTextures& GetMaterialTextures(uint32_t materialIndex) const;
 
 		void SetFovAngle(const float newFovAngle);
 		void SetAspectRatio(const float newAspectRatio);
@@ -122,5 +251,18 @@ namespace dae
 
 
 		void DepthRemap(float& depth, float topPercentile) const;
+		void ResolveDepthView(float minDepth) const;
+		//Sizes and zeroes the buffer of the displayed heatmap
+		void ResetHeatmap() const;
+		//Spreads ticks evenly over the blocks under the (inclusive) bounding box, for the W3 list that doesn't walk blocks
+		void AddHeatmapTime(int left, int bottom, int right, int top, uint64_t ticks) const;
+		//Adds the ticks of one raster block, (x, y) is any pixel in it
+		void AddHeatmapBlockTime(int x, int y, uint64_t ticks) const;
+		//Replaces every pixel with the displayed heatmap, does nothing for the other modes
+		void ResolveHeatmap() const;
+		int GetNrHeatmapBlocksX() const { return (m_Width + HeatmapBlockSize - 1) / HeatmapBlockSize; }
+		static ColorRGB GetHeatmapColor(float value);
+		//Depth as 0 near and 1 far, regardless of reversed-Z
+		float GetViewDepth(float depth) const;
 	};
 }
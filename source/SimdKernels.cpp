@@ -0,0 +1,127 @@
+#include "SimdKernels.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		void ReadCpuid(uint32_t leaf, uint32_t subLeaf, uint32_t registers[4])
+		{
+#ifdef _MSC_VER
+			int values[4]{};
+			__cpuidex(values, int(leaf), int(subLeaf));
+			std::memcpy(registers, values, sizeof(values));
+#else
+			__cpuid_count(leaf, subLeaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+		}
+
+		// which register states the OS saves on a context switch
+		uint64_t ReadEnabledStates()
+		{
+#ifdef _MSC_VER
+			return _xgetbv(0);
+#else
+			uint32_t low{}, high{};
+			__asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+			return (uint64_t(high) << 32) | low;
+#endif
+		}
+
+		SimdLevel GetLevelFromEnvironment(SimdLevel supportedLevel)
+		{
+			const char* pValue = std::getenv("RASTERIZER_SIMD");
+			if (!pValue)
+				return supportedLevel;
+
+			for (SimdLevel level : { SimdLevel::SSE2, SimdLevel::SSE42, SimdLevel::AVX2, SimdLevel::AVX512 })
+			{
+				// never above what the CPU runs
+				if (std::strcmp(pValue, GetSimdLevelName(level)) == 0)
+					return level < supportedLevel ? level : supportedLevel;
+			}
+
+			return supportedLevel;
+		}
+
+		SimdKernels SelectKernels()
+		{
+			switch (GetLevelFromEnvironment(GetSupportedSimdLevel()))
+			{
+			case SimdLevel::AVX512:
+				return simd::Avx512::GetKernels();
+			case SimdLevel::AVX2:
+				return simd::Avx2::GetKernels();
+			case SimdLevel::SSE42:
+				return simd::Sse42::GetKernels();
+			default:
+				return simd::Sse2::GetKernels();
+			}
+		}
+	}
+
+	const SimdKernels& GetSimdKernels()
+	{
+		static const SimdKernels kernels{ SelectKernels() };
+		return kernels;
+	}
+
+	SimdLevel GetSupportedSimdLevel()
+	{
+		uint32_t registers[4]{};
+		ReadCpuid(0, 0, registers);
+		const uint32_t maxLeaf = registers[0];
+
+		ReadCpuid(1, 0, registers);
+		const bool hasSse42 = registers[2] & (1u << 20);
+		const bool hasOsXsave = registers[2] & (1u << 27);
+		const bool hasFma = registers[2] & (1u << 12);
+		if (!hasSse42)
+			return SimdLevel::SSE2;
+		if (!hasOsXsave || maxLeaf < 7)
+			return SimdLevel::SSE42;
+
+		// SSE and AVX state, then the AVX-512 mask and upper register states
+		const uint64_t enabledStates = ReadEnabledStates();
+		const bool isAvxEnabled = (enabledStates & 0x6) == 0x6;
+		const bool isAvx512Enabled = (enabledStates & 0xe6) == 0xe6;
+
+		ReadCpuid(7, 0, registers);
+		const bool hasAvx2 = registers[1] & (1u << 5);
+		const bool hasAvx512 = (registers[1] & (1u << 16)) // F
+			&& (registers[1] & (1u << 17)) // DQ
+			&& (registers[1] & (1u << 30)) // BW
+			&& (registers[1] & (1u << 31)); // VL
+
+		if (!isAvxEnabled || !hasAvx2 || !hasFma)
+			return SimdLevel::SSE42;
+		if (!isAvx512Enabled || !hasAvx512)
+			return SimdLevel::AVX2;
+		return SimdLevel::AVX512;
+	}
+
+	const char* GetSimdLevelName(SimdLevel level)
+	{
+		switch (level)
+		{
+		case SimdLevel::SSE42:
+			return "sse4.2";
+		case SimdLevel::AVX2:
+			return "avx2";
+		case SimdLevel::AVX512:
+			return "avx512";
+		default:
+			return "sse2";
+		}
+	}
+}
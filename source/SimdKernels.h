@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace dae
+{
+	struct ColorRGB;
+	struct PixelLayout;
+
+	enum class SimdLevel
+	{
+		SSE2,
+		SSE42,
+		AVX2,
+		AVX512
+	};
+
+	//Hot loops compiled once per instruction set, see SimdKernels.inl. The table of the widest set
+	//the CPU and OS support is picked on first use
+	struct SimdKernels
+	{
+		SimdLevel level{};
+		void (*packColors)(const ColorRGB* pColors, uint32_t* pPixels, size_t count, const PixelLayout& layout){};
+		//Points (x, y, z, 1) times the 16 floats of a row-major Matrix, in and out as structures of arrays.
+		//Same results as Matrix::TransformPoint
+		void (*transformPoints)(const float* pMatrix, const float* pX, const float* pY, const float* pZ,
+			float* pOutX, float* pOutY, float* pOutZ, float* pOutW, size_t count){};
+	};
+
+	//RASTERIZER_SIMD=sse2|sse4.2|avx2|avx512 caps the level, e.g. to compare the variants
+	const SimdKernels& GetSimdKernels();
+	SimdLevel GetSupportedSimdLevel();
+	const char* GetSimdLevelName(SimdLevel level);
+
+	//One table per variant, in SimdKernels_<level>.cpp
+	namespace simd
+	{
+		namespace Sse2 { SimdKernels GetKernels(); }
+		namespace Sse42 { SimdKernels GetKernels(); }
+		namespace Avx2 { SimdKernels GetKernels(); }
+		namespace Avx512 { SimdKernels GetKernels(); }
+	}
+}
@@ -0,0 +1,257 @@
+//Kernel bodies, included by every SimdKernels_<level>.cpp with SIMD_KERNELS_NAMESPACE and SIMD_KERNELS_LEVEL
+//defined. Those files are compiled with their own instruction set, the preprocessor picks the widest path.
+//Use nothing but this file and intrinsics: an inline function or template of a shared header would be compiled
+//with the wider instruction set too and the linker may hand that copy to every caller, on any CPU.
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+#include "PixelPacking.h"
+#include "SimdKernels.h"
+
+namespace dae::simd::SIMD_KERNELS_NAMESPACE
+{
+	namespace
+	{
+#if defined(__AVX512F__)
+		// the 4 floats at pFloats, + 12, + 24 and + 36, one per 128 bit lane
+		__m512 LoadLanes(const float* pFloats)
+		{
+			__m512 lanes = _mm512_castps128_ps512(_mm_loadu_ps(pFloats));
+			lanes = _mm512_insertf32x4(lanes, _mm_loadu_ps(pFloats + 12), 1);
+			lanes = _mm512_insertf32x4(lanes, _mm_loadu_ps(pFloats + 24), 2);
+			return _mm512_insertf32x4(lanes, _mm_loadu_ps(pFloats + 36), 3);
+		}
+#endif
+
+		void PackColors(const ColorRGB* pColors, uint32_t* pPixels, size_t count, const PixelLayout& layout)
+		{
+			static_assert(sizeof(ColorRGB) == 3 * sizeof(float), "PackColors expects tightly packed colors");
+
+			// every path does the same per color: MaxToOne, clamp negatives, scale, truncate and shift.
+			// Dividing by 1 leaves colors that are already in range untouched
+			const __m128i redShift = _mm_cvtsi32_si128(int(layout.redShift));
+			const __m128i greenShift = _mm_cvtsi32_si128(int(layout.greenShift));
+			const __m128i blueShift = _mm_cvtsi32_si128(int(layout.blueShift));
+
+			size_t i{};
+
+#if defined(__AVX512F__)
+			{
+				const __m512 one = _mm512_set1_ps(1.f);
+				const __m512 zero = _mm512_setzero_ps();
+				const __m512 scale = _mm512_set1_ps(255.f);
+				const __m512i alphaMask = _mm512_set1_epi32(int(layout.alphaMask));
+
+				for (; i + 16 <= count; i += 16)
+				{
+					// 4 colors per 128 bit lane, the shuffles below work per lane like the SSE path
+					const float* pFloats = &pColors[i].r;
+					const __m512 a = LoadLanes(pFloats);
+					const __m512 b = LoadLanes(pFloats + 4);
+					const __m512 c = LoadLanes(pFloats + 8);
+
+					const __m512 r = _mm512_shuffle_ps(a, _mm512_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+					const __m512 g = _mm512_shuffle_ps(_mm512_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1)), _mm512_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+					const __m512 bl = _mm512_shuffle_ps(_mm512_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2)), _mm512_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+					const __m512 divisor = _mm512_max_ps(_mm512_max_ps(r, _mm512_max_ps(g, bl)), one);
+
+					const __m512i red = _mm512_cvttps_epi32(_mm512_mul_ps(_mm512_max_ps(_mm512_div_ps(r, divisor), zero), scale));
+					const __m512i green = _mm512_cvttps_epi32(_mm512_mul_ps(_mm512_max_ps(_mm512_div_ps(g, divisor), zero), scale));
+					const __m512i blue = _mm512_cvttps_epi32(_mm512_mul_ps(_mm512_max_ps(_mm512_div_ps(bl, divisor), zero), scale));
+
+					__m512i packed = _mm512_or_si512(_mm512_sll_epi32(red, redShift), _mm512_sll_epi32(green, greenShift));
+					packed = _mm512_or_si512(packed, _mm512_or_si512(_mm512_sll_epi32(blue, blueShift), alphaMask));
+
+					_mm512_storeu_si512(pPixels + i, packed);
+				}
+			}
+#endif
+
+#if defined(__AVX2__)
+			{
+				const __m256 one = _mm256_set1_ps(1.f);
+				const __m256 zero = _mm256_setzero_ps();
+				const __m256 scale = _mm256_set1_ps(255.f);
+				const __m256i alphaMask = _mm256_set1_epi32(int(layout.alphaMask));
+
+				for (; i + 8 <= count; i += 8)
+				{
+					// 4 colors per 128 bit lane, the shuffles below work per lane like the SSE path
+					const float* pFloats = &pColors[i].r;
+					const __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pFloats)), _mm_loadu_ps(pFloats + 12), 1);
+					const __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pFloats + 4)), _mm_loadu_ps(pFloats + 16), 1);
+					const __m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pFloats + 8)), _mm_loadu_ps(pFloats + 20), 1);
+
+					const __m256 r = _mm256_shuffle_ps(a, _mm256_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+					const __m256 g = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1)), _mm256_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+					const __m256 bl = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2)), _mm256_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+					const __m256 divisor = _mm256_max_ps(_mm256_max_ps(r, _mm256_max_ps(g, bl)), one);
+
+					const __m256i red = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_max_ps(_mm256_div_ps(r, divisor), zero), scale));
+					const __m256i green = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_max_ps(_mm256_div_ps(g, divisor), zero), scale));
+					const __m256i blue = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_max_ps(_mm256_div_ps(bl, divisor), zero), scale));
+
+					__m256i packed = _mm256_or_si256(_mm256_sll_epi32(red, redShift), _mm256_sll_epi32(green, greenShift));
+					packed = _mm256_or_si256(packed, _mm256_or_si256(_mm256_sll_epi32(blue, blueShift), alphaMask));
+
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(pPixels + i), packed);
+				}
+			}
+#endif
+
+			{
+				const __m128 one = _mm_set1_ps(1.f);
+				const __m128 zero = _mm_setzero_ps();
+				const __m128 scale = _mm_set1_ps(255.f);
+				const __m128i alphaMask = _mm_set1_epi32(int(layout.alphaMask));
+
+				for (; i + 4 <= count; i += 4)
+				{
+					// 4 colors are 3 registers: r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+					const float* pFloats = &pColors[i].r;
+					const __m128 a = _mm_loadu_ps(pFloats);
+					const __m128 b = _mm_loadu_ps(pFloats + 4);
+					const __m128 c = _mm_loadu_ps(pFloats + 8);
+
+					// transpose to one channel per register
+#if defined(__SSE4_1__) || defined(__AVX__) || defined(SIMD_KERNELS_SSE41)
+					// blends gather each channel in one register, out of order, a single shuffle sorts it:
+					// r0 r3 r2 r1 | g1 g0 g3 g2 | b2 b1 b0 b3
+					const __m128 rMixed = _mm_blend_ps(_mm_blend_ps(a, b, 0b0100), c, 0b0010);
+					const __m128 gMixed = _mm_blend_ps(_mm_blend_ps(a, b, 0b1001), c, 0b0100);
+					const __m128 bMixed = _mm_blend_ps(_mm_blend_ps(a, b, 0b0010), c, 0b1001);
+					const __m128 r = _mm_shuffle_ps(rMixed, rMixed, _MM_SHUFFLE(1, 2, 3, 0));
+					const __m128 g = _mm_shuffle_ps(gMixed, gMixed, _MM_SHUFFLE(2, 3, 0, 1));
+					const __m128 bl = _mm_shuffle_ps(bMixed, bMixed, _MM_SHUFFLE(3, 0, 1, 2));
+#else
+					const __m128 r = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+					const __m128 g = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+					const __m128 bl = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+#endif
+
+					const __m128 divisor = _mm_max_ps(_mm_max_ps(r, _mm_max_ps(g, bl)), one);
+
+					const __m128i red = _mm_cvttps_epi32(_mm_mul_ps(_mm_max_ps(_mm_div_ps(r, divisor), zero), scale));
+					const __m128i green = _mm_cvttps_epi32(_mm_mul_ps(_mm_max_ps(_mm_div_ps(g, divisor), zero), scale));
+					const __m128i blue = _mm_cvttps_epi32(_mm_mul_ps(_mm_max_ps(_mm_div_ps(bl, divisor), zero), scale));
+
+					__m128i packed = _mm_or_si128(_mm_sll_epi32(red, redShift), _mm_sll_epi32(green, greenShift));
+					packed = _mm_or_si128(packed, _mm_or_si128(_mm_sll_epi32(blue, blueShift), alphaMask));
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels + i), packed);
+				}
+			}
+
+			// same as ColorRGB::MaxToOne and PackColor, spelled out for the reason at the top
+			for (; i < count; ++i)
+			{
+				float r = pColors[i].r;
+				float g = pColors[i].g;
+				float b = pColors[i].b;
+
+				const float maxGB = g < b ? b : g;
+				const float maxValue = r < maxGB ? maxGB : r;
+				if (maxValue > 1.f)
+				{
+					r /= maxValue;
+					g /= maxValue;
+					b /= maxValue;
+				}
+
+				pPixels[i] = (static_cast<uint32_t>(r * 255) << layout.redShift)
+					| (static_cast<uint32_t>(g * 255) << layout.greenShift)
+					| (static_cast<uint32_t>(b * 255) << layout.blueShift)
+					| layout.alphaMask;
+			}
+		}
+
+		void TransformPoints(const float* pMatrix, const float* pX, const float* pY, const float* pZ,
+			float* pOutX, float* pOutY, float* pOutZ, float* pOutW, size_t count)
+		{
+			// every path adds x * row 0 + y * row 1 + z * row 2 + row 3 in that order and without fused
+			// multiply-adds, so all levels and Matrix::TransformPoint round the same way
+			float* const pOuts[4]{ pOutX, pOutY, pOutZ, pOutW };
+
+			size_t i{};
+
+#if defined(__AVX512F__)
+			{
+				__m512 m[16];
+				for (int k{}; k < 16; ++k)
+					m[k] = _mm512_set1_ps(pMatrix[k]);
+
+				for (; i + 16 <= count; i += 16)
+				{
+					const __m512 x = _mm512_loadu_ps(pX + i);
+					const __m512 y = _mm512_loadu_ps(pY + i);
+					const __m512 z = _mm512_loadu_ps(pZ + i);
+
+					for (int c{}; c < 4; ++c)
+					{
+						const __m512 xy = _mm512_add_ps(_mm512_mul_ps(x, m[c]), _mm512_mul_ps(y, m[4 + c]));
+						_mm512_storeu_ps(pOuts[c] + i, _mm512_add_ps(_mm512_add_ps(xy, _mm512_mul_ps(z, m[8 + c])), m[12 + c]));
+					}
+				}
+			}
+#endif
+
+#if defined(__AVX2__)
+			{
+				__m256 m[16];
+				for (int k{}; k < 16; ++k)
+					m[k] = _mm256_set1_ps(pMatrix[k]);
+
+				for (; i + 8 <= count; i += 8)
+				{
+					const __m256 x = _mm256_loadu_ps(pX + i);
+					const __m256 y = _mm256_loadu_ps(pY + i);
+					const __m256 z = _mm256_loadu_ps(pZ + i);
+
+					for (int c{}; c < 4; ++c)
+					{
+						const __m256 xy = _mm256_add_ps(_mm256_mul_ps(x, m[c]), _mm256_mul_ps(y, m[4 + c]));
+						_mm256_storeu_ps(pOuts[c] + i, _mm256_add_ps(_mm256_add_ps(xy, _mm256_mul_ps(z, m[8 + c])), m[12 + c]));
+					}
+				}
+			}
+#endif
+
+			{
+				__m128 m[16];
+				for (int k{}; k < 16; ++k)
+					m[k] = _mm_set1_ps(pMatrix[k]);
+
+				for (; i + 4 <= count; i += 4)
+				{
+					const __m128 x = _mm_loadu_ps(pX + i);
+					const __m128 y = _mm_loadu_ps(pY + i);
+					const __m128 z = _mm_loadu_ps(pZ + i);
+
+					for (int c{}; c < 4; ++c)
+					{
+						const __m128 xy = _mm_add_ps(_mm_mul_ps(x, m[c]), _mm_mul_ps(y, m[4 + c]));
+						_mm_storeu_ps(pOuts[c] + i, _mm_add_ps(_mm_add_ps(xy, _mm_mul_ps(z, m[8 + c])), m[12 + c]));
+					}
+				}
+			}
+
+			for (; i < count; ++i)
+			{
+				for (int c{}; c < 4; ++c)
+					pOuts[c][i] = pX[i] * pMatrix[c] + pY[i] * pMatrix[4 + c] + pZ[i] * pMatrix[8 + c] + pMatrix[12 + c];
+			}
+		}
+	}
+
+	SimdKernels GetKernels()
+	{
+		SimdKernels kernels{};
+		kernels.level = SIMD_KERNELS_LEVEL;
+		kernels.packColors = &PackColors;
+		kernels.transformPoints = &TransformPoints;
+		return kernels;
+	}
+}
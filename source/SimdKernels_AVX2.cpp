@@ -0,0 +1,4 @@
+//Compiled with AVX2 and FMA enabled (-mavx2 -mfma, /arch:AVX2), see CMakeLists.txt and Rasterizer.vcxproj
+#define SIMD_KERNELS_NAMESPACE Avx2
+#define SIMD_KERNELS_LEVEL SimdLevel::AVX2
+#include "SimdKernels.inl"
@@ -0,0 +1,4 @@
+//Compiled with AVX-512 enabled (-mavx512f -mavx512bw -mavx512dq -mavx512vl, /arch:AVX512), see CMakeLists.txt and Rasterizer.vcxproj
+#define SIMD_KERNELS_NAMESPACE Avx512
+#define SIMD_KERNELS_LEVEL SimdLevel::AVX512
+#include "SimdKernels.inl"
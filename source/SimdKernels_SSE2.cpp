@@ -0,0 +1,4 @@
+//Compiled with the x64 baseline, no extra instruction set, see CMakeLists.txt and Rasterizer.vcxproj
+#define SIMD_KERNELS_NAMESPACE Sse2
+#define SIMD_KERNELS_LEVEL SimdLevel::SSE2
+#include "SimdKernels.inl"
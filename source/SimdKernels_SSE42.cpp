@@ -0,0 +1,8 @@
+//Compiled with SSE4.2 enabled (-msse4.2), see CMakeLists.txt. The kernels use SSE4.1 blends at this level.
+//MSVC has no switch for it and never defines __SSE4_1__, its SSE4.1 intrinsics are available without one
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_KERNELS_SSE41
+#endif
+#define SIMD_KERNELS_NAMESPACE Sse42
+#define SIMD_KERNELS_LEVEL SimdLevel::SSE42
+#include "SimdKernels.inl"
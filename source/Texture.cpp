@@ -1,5 +1,6 @@
 #include "Texture.h"
 #include "Vector2.h"
+#include "ThreadPool.h"
 #include <SDL_image.h>
 
 namespace dae
@@ -24,7 +25,16 @@ namespace dae
 		//Load SDL_Surface using IMG_LOAD
 		//Create & Return a new Texture Object (using SDL_Surface)
 
-		return new Texture{ IMG_Load(path.c_str()) };
+		SDL_Surface* pSurface = IMG_Load(path.c_str());
+		if (!pSurface)
+			return nullptr;
+
+		return new Texture{ pSurface };
+	}
+
+	TextureHandle Texture::LoadFromFileAsync(const std::string& path, ThreadPool& threadPool)
+	{
+		return TextureHandle{ threadPool.Enqueue([path]() { return LoadFromFile(path); }).share() };
 	}
 
 	ColorRGB Texture::Sample(const Vector2& uv) const
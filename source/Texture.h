@@ -1,18 +1,25 @@
 #pragma once
 #include <SDL_surface.h>
+#include <atomic>
+#include <future>
 #include <string>
 #include "ColorRGB.h"
 
 namespace dae
 {
 	struct Vector2;
+	class ThreadPool;
+	class TextureHandle;
 
 	class Texture
 	{
 	public:
 		~Texture();
 
+		//Returns nullptr when the file can't be loaded
 		static Texture* LoadFromFile(const std::string& path);
+		//Decodes the file on the pool, the handle only blocks when the texture is first used
+		static TextureHandle LoadFromFileAsync(const std::string& path, ThreadPool& threadPool);
 		ColorRGB Sample(const Vector2& uv) const;
 
 	private:
@@ -21,4 +28,49 @@ namespace dae
 		SDL_Surface* m_pSurface{ nullptr };
 		uint32_t* m_pSurfacePixels{ nullptr };
 	};
-}
\ No newline at end of file
+
+	//Texture that might still be decoding, owned by whoever requested the load
+	class TextureHandle final
+	{
+	public:
+		TextureHandle() = default;
+		explicit TextureHandle(std::shared_future<Texture*> future) : m_Future{ std::move(future) } {}
+
+		TextureHandle(const TextureHandle& other) : m_Future{ other.m_Future } {}
+		TextureHandle& operator=(const TextureHandle& other)
+		{
+			m_Future = other.m_Future;
+			m_pTexture = nullptr;
+			m_IsResolved = false;
+			return *this;
+		}
+
+		//Waits for the decode the first time, afterwards it is a plain pointer read.
+		//nullptr for an empty handle or a file that failed to load.
+		Texture* Get() const
+		{
+			if (m_IsResolved.load(std::memory_order_acquire))
+				return m_pTexture;
+
+			if (!m_Future.valid())
+				return nullptr;
+
+			m_pTexture = m_Future.get();
+			m_IsResolved.store(true, std::memory_order_release);
+			return m_pTexture;
+		}
+
+		bool IsReady() const
+		{
+			return m_Future.valid() && m_Future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}
+
+		const Texture* operator->() const { return Get(); }
+
+	private:
+		std::shared_future<Texture*> m_Future{};
+		// Get can be called from several threads, they all store the same pointer
+		mutable std::atomic<Texture*> m_pTexture{ nullptr };
+		mutable std::atomic<bool> m_IsResolved{ false };
+	};
+}
@@ -0,0 +1,29 @@
+#include "TextureCache.h"
+#include <filesystem>
+
+namespace dae
+{
+	TextureCache::TextureCache(ThreadPool& threadPool) :
+		m_ThreadPool{ threadPool }
+	{
+	}
+
+	TextureCache::~TextureCache()
+	{
+		// Get waits for loads that are still in flight
+		for (const auto& [path, texture] : m_Textures)
+			delete texture.Get();
+	}
+
+	TextureHandle TextureCache::Load(const std::string& path)
+	{
+		// "Resources/./a.png" and "Resources\a.png" are the same file
+		const std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+
+		const auto it = m_Textures.find(key);
+		if (it != m_Textures.end())
+			return it->second;
+
+		return m_Textures.emplace(key, Texture::LoadFromFileAsync(key, m_ThreadPool)).first->second;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+#include "Texture.h"
+
+namespace dae
+{
+	class ThreadPool;
+
+	//Owns every texture loaded through it, keyed by path, so textures shared between
+	//materials or meshes are only decoded and stored once.
+	class TextureCache final
+	{
+	public:
+		explicit TextureCache(ThreadPool& threadPool);
+		~TextureCache();
+
+		TextureCache(const TextureCache&) = delete;
+		TextureCache(TextureCache&&) noexcept = delete;
+		TextureCache& operator=(const TextureCache&) = delete;
+		TextureCache& operator=(TextureCache&&) noexcept = delete;
+
+		//The first request for a path starts the (async) decode, later ones share it
+		TextureHandle Load(const std::string& path);
+
+		size_t GetSize() const { return m_Textures.size(); }
+
+	private:
+		ThreadPool& m_ThreadPool;
+		std::unordered_map<std::string, TextureHandle> m_Textures{};
+	};
+}
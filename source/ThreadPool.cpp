@@ -0,0 +1,74 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace dae
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		// hardware_concurrency is allowed to report 0
+		threadCount = std::max(threadCount, 1u);
+
+		m_Workers.reserve(threadCount);
+		for (uint32_t i{}; i < threadCount; ++i)
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ m_QueueMutex };
+			m_IsStopping = true;
+		}
+		m_QueueCondition.notify_all();
+
+		for (std::thread& worker : m_Workers)
+			worker.join();
+	}
+
+	void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& func, size_t minRangeSize)
+	{
+		if (count == 0)
+			return;
+
+		minRangeSize = std::max(minRangeSize, size_t{ 1 });
+
+		const size_t maxRanges = (count + minRangeSize - 1) / minRangeSize;
+		const size_t nrRanges = std::min(static_cast<size_t>(GetThreadCount()) + 1, maxRanges);
+		const size_t rangeSize = (count + nrRanges - 1) / nrRanges;
+
+		std::vector<std::future<void>> pending{};
+		pending.reserve(nrRanges);
+
+		for (size_t begin = rangeSize; begin < count; begin += rangeSize)
+		{
+			const size_t end = std::min(begin + rangeSize, count);
+			pending.push_back(Enqueue([&func, begin, end]() { func(begin, end); }));
+		}
+
+		func(0, std::min(rangeSize, count));
+
+		for (std::future<void>& future : pending)
+			future.get();
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task{};
+			{
+				std::unique_lock lock{ m_QueueMutex };
+				m_QueueCondition.wait(lock, [this]() { return m_IsStopping || !m_Tasks.empty(); });
+
+				// finish the queued work before shutting down
+				if (m_Tasks.empty())
+					return;
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace dae
+{
+	class ThreadPool final
+	{
+	public:
+		explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		//Queues func on one of the workers, the future becomes ready once it ran
+		template<typename Func>
+		std::future<std::invoke_result_t<Func>> Enqueue(Func&& func)
+		{
+			using Result = std::invoke_result_t<Func>;
+
+			// std::function needs a copyable target, so the task lives behind a shared_ptr
+			const auto pTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+			std::future<Result> future = pTask->get_future();
+			{
+				std::lock_guard lock{ m_QueueMutex };
+				m_Tasks.emplace([pTask]() { (*pTask)(); });
+			}
+			m_QueueCondition.notify_one();
+
+			return future;
+		}
+
+		//Splits [0, count) into contiguous ranges and runs func(begin, end) on them in parallel.
+		//The calling thread takes one of the ranges and returns once all of them are done.
+		void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& func, size_t minRangeSize = 256);
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+	private:
+		std::vector<std::thread> m_Workers{};
+
+		std::mutex m_QueueMutex{};
+		std::condition_variable m_QueueCondition{};
+		std::queue<std::function<void()>> m_Tasks{};
+		bool m_IsStopping{ false };
+
+		void WorkerLoop();
+	};
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "DataTypes.h"
+#include "Math.h"
+
+namespace dae
+{
+	//Raster positions are snapped to 24.8 fixed point before any coverage test
+	constexpr int SubpixelBits{ 8 };
+	constexpr int SubpixelScale{ 1 << SubpixelBits };
+
+	inline int32_t ToFixed(float value)
+	{
+		return int32_t(std::lround(value * SubpixelScale));
+	}
+
+	//Edge function of a directed edge between fixed point positions, at whole pixel positions. Not negative
+	//on the inside of a triangle with a positive area. Integer math is exact, so with the top-left rule a
+	//sample on an edge shared by two triangles is covered by exactly one of them
+	struct EdgeFunction
+	{
+		// value at pixel (0, 0) and the change per pixel to the right and down
+		int64_t constant{};
+		int64_t stepX{};
+		int64_t stepY{};
+
+		EdgeFunction(const Int2& from, const Int2& to)
+		{
+			const int64_t dx = int64_t(to.x) - from.x;
+			const int64_t dy = int64_t(to.y) - from.y;
+			stepX = -dy * SubpixelScale;
+			stepY = dx * SubpixelScale;
+
+			// y points down: the inside is below a top edge that goes right, and right of a left edge that goes up.
+			// Samples exactly on other edges belong to the neighbouring triangle
+			const bool isTopLeft = dy < 0 || (dy == 0 && dx > 0);
+			constant = dy * from.x - dx * from.y - (isTopLeft ? 0 : 1);
+		}
+
+		int64_t Evaluate(int x, int y) const
+		{
+			return constant + x * stepX + y * stepY;
+		}
+
+		//Smallest and largest value over the pixels [left, right] x [bottom, top], found at opposite corners
+		int64_t GetMin(int left, int bottom, int right, int top) const
+		{
+			return Evaluate(left, bottom) + std::min(stepX * (right - left), int64_t{}) + std::min(stepY * (top - bottom), int64_t{});
+		}
+
+		int64_t GetMax(int left, int bottom, int right, int top) const
+		{
+			return Evaluate(left, bottom) + std::max(stepX * (right - left), int64_t{}) + std::max(stepY * (top - bottom), int64_t{});
+		}
+	};
+
+	//An attribute that is linear in screen space: its value at the first vertex and how much it changes per pixel
+	template<typename T>
+	struct AttributePlane
+	{
+		T origin{};
+		T ddx{};
+		T ddy{};
+
+		//offset is the pixel position minus the first vertex
+		T Evaluate(const Vector2& offset) const
+		{
+			return origin + ddx * offset.x + ddy * offset.y;
+		}
+	};
+
+	//Per triangle constants of the pixel loop. Attributes are divided by w at the vertices, which makes them linear
+	//in screen space, a pixel multiplies them by its interpolated w again. That leaves one reciprocal per pixel
+	struct TriangleSetup
+	{
+		//NDC depth is linear in screen space already
+		AttributePlane<float> depth{};
+		AttributePlane<float> invW{};
+		AttributePlane<Vector2> uv{};
+		AttributePlane<Vector3> normal{};
+		AttributePlane<Vector3> tangent{};
+		AttributePlane<Vector3> viewDirection{};
+
+		//Vertices in raster space, area is the cross product of the edges from the first vertex and positive.
+		//Passed in because the float cross product of snapped positions can round to zero
+		TriangleSetup(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, float area)
+		{
+			const Vector2 edge1 = v1.position.GetXY() - v0.position.GetXY();
+			const Vector2 edge2 = v2.position.GetXY() - v0.position.GetXY();
+			const float invArea = 1.f / area;
+
+			// how the barycentric weights of the second and third vertex change per pixel
+			const Vector2 weight1Gradient{ edge2.y * invArea, -edge2.x * invArea };
+			const Vector2 weight2Gradient{ -edge1.y * invArea, edge1.x * invArea };
+
+			const float invW0 = 1.f / v0.position.w;
+			const float invW1 = 1.f / v1.position.w;
+			const float invW2 = 1.f / v2.position.w;
+
+			depth = CreatePlane(v0.position.z, v1.position.z, v2.position.z, weight1Gradient, weight2Gradient);
+			invW = CreatePlane(invW0, invW1, invW2, weight1Gradient, weight2Gradient);
+			uv = CreatePlane(v0.uv * invW0, v1.uv * invW1, v2.uv * invW2, weight1Gradient, weight2Gradient);
+			normal = CreatePlane(v0.normal * invW0, v1.normal * invW1, v2.normal * invW2, weight1Gradient, weight2Gradient);
+			tangent = CreatePlane(v0.tangent * invW0, v1.tangent * invW1, v2.tangent * invW2, weight1Gradient, weight2Gradient);
+			viewDirection = CreatePlane(v0.viewDirection * invW0, v1.viewDirection * invW1, v2.viewDirection * invW2, weight1Gradient, weight2Gradient);
+		}
+
+	private:
+		template<typename T>
+		static AttributePlane<T> CreatePlane(const T& a0, const T& a1, const T& a2, const Vector2& weight1Gradient, const Vector2& weight2Gradient)
+		{
+			const T delta1 = a1 - a0;
+			const T delta2 = a2 - a0;
+			return { a0, delta1 * weight1Gradient.x + delta2 * weight2Gradient.x, delta1 * weight1Gradient.y + delta2 * weight2Gradient.y };
+		}
+	};
+}
@@ -1,8 +1,15 @@
 #pragma once
 #include <cassert>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <string>
+#include <xmmintrin.h>
 #include "Math.h"
 #include "DataTypes.h"
+#include "ThreadPool.h"
 
 //#define DISABLE_OBJ
 
@@ -10,15 +17,284 @@ namespace dae
 {
 	namespace Utils
 	{
-		//Just parses vertices and indices
+		//Computes per vertex tangents from the positions and UVs of the triangles they are used in.
+		//Runs as a per triangle pass followed by a per vertex gather, both split over the pool when one is given.
 #pragma warning(push)
 #pragma warning(disable : 4505) //Warning unreferenced local function
-		static bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		static void CalculateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, ThreadPool* pThreadPool = nullptr)
+		{
+			const size_t nrTriangles = indices.size() / 3;
+
+			const auto parallelFor = [pThreadPool](size_t count, const std::function<void(size_t, size_t)>& func)
+			{
+				if (pThreadPool)
+					pThreadPool->ParallelFor(count, func);
+				else
+					func(0, count);
+			};
+
+			// Per triangle: normalized UV tangent plus the angle at each corner to weight it with,
+			// so a vertex isn't dominated by the finely tessellated side of the mesh
+			std::vector<Vector3> triangleTangents(nrTriangles);
+			std::vector<float> cornerWeights(nrTriangles * 3);
+
+			const auto calculateTriangle = [&](size_t t)
+			{
+				const Vertex& v0 = vertices[indices[t * 3]];
+				const Vertex& v1 = vertices[indices[t * 3 + 1]];
+				const Vertex& v2 = vertices[indices[t * 3 + 2]];
+
+				const Vector3 edge0 = v1.position - v0.position;
+				const Vector3 edge1 = v2.position - v0.position;
+				const Vector2 diffX = Vector2(v1.uv.x - v0.uv.x, v2.uv.x - v0.uv.x);
+				const Vector2 diffY = Vector2(v1.uv.y - v0.uv.y, v2.uv.y - v0.uv.y);
+				const float uvArea = Vector2::Cross(diffX, diffY);
+
+				// Degenerate UVs don't define a tangent, leave it to the neighbours (or the fallback below).
+				// Only the sign of the area is used, so tiny but valid UV triangles are fine.
+				if (uvArea == 0.f)
+				{
+					triangleTangents[t] = Vector3::Zero;
+					return;
+				}
+
+				// the sign of the UV area keeps mirrored UV islands pointing the right way
+				const Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * (uvArea > 0.f ? 1.f : -1.f);
+				const float tangentLength = tangent.Magnitude();
+				triangleTangents[t] = tangentLength > 0.f ? tangent / tangentLength : Vector3::Zero;
+
+				const Vector3 edge2 = v2.position - v1.position;
+				const auto cornerAngle = [](const Vector3& a, const Vector3& b)
+				{
+					const float lengths = a.Magnitude() * b.Magnitude();
+					return lengths > 0.f ? std::acos(Clamp(Vector3::Dot(a, b) / lengths, -1.f, 1.f)) : 0.f;
+				};
+				cornerWeights[t * 3] = cornerAngle(edge0, edge1);
+				cornerWeights[t * 3 + 1] = cornerAngle(-edge0, edge2);
+				cornerWeights[t * 3 + 2] = cornerAngle(-edge1, -edge2);
+			};
+
+			parallelFor(nrTriangles, [&](size_t begin, size_t end)
+				{
+					// 4 triangles at a time, one per lane. Every lane does the same operations in the same order as
+					// calculateTriangle, so the results are identical. Only the acos is left to the scalar library
+					size_t t = begin;
+					for (; t + 4 <= end; t += 4)
+					{
+						// gathered into structures of arrays: [corner][axis][lane]
+						alignas(16) float positions[3][3][4];
+						alignas(16) float uvs[3][2][4];
+						for (int lane = 0; lane < 4; ++lane)
+						{
+							for (int corner = 0; corner < 3; ++corner)
+							{
+								const Vertex& v = vertices[indices[(t + lane) * 3 + corner]];
+								positions[corner][0][lane] = v.position.x;
+								positions[corner][1][lane] = v.position.y;
+								positions[corner][2][lane] = v.position.z;
+								uvs[corner][0][lane] = v.uv.x;
+								uvs[corner][1][lane] = v.uv.y;
+							}
+						}
+
+						__m128 edge0[3], edge1[3], edge2[3];
+						for (int axis = 0; axis < 3; ++axis)
+						{
+							const __m128 p0 = _mm_load_ps(positions[0][axis]);
+							const __m128 p1 = _mm_load_ps(positions[1][axis]);
+							const __m128 p2 = _mm_load_ps(positions[2][axis]);
+							edge0[axis] = _mm_sub_ps(p1, p0);
+							edge1[axis] = _mm_sub_ps(p2, p0);
+							edge2[axis] = _mm_sub_ps(p2, p1);
+						}
+
+						const __m128 diffXx = _mm_sub_ps(_mm_load_ps(uvs[1][0]), _mm_load_ps(uvs[0][0]));
+						const __m128 diffXy = _mm_sub_ps(_mm_load_ps(uvs[2][0]), _mm_load_ps(uvs[0][0]));
+						const __m128 diffYx = _mm_sub_ps(_mm_load_ps(uvs[1][1]), _mm_load_ps(uvs[0][1]));
+						const __m128 diffYy = _mm_sub_ps(_mm_load_ps(uvs[2][1]), _mm_load_ps(uvs[0][1]));
+						const __m128 uvArea = _mm_sub_ps(_mm_mul_ps(diffXx, diffYy), _mm_mul_ps(diffXy, diffYx));
+
+						const __m128 zero = _mm_setzero_ps();
+						const __m128 one = _mm_set1_ps(1.f);
+						const __m128 sign = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(uvArea, zero), one), _mm_andnot_ps(_mm_cmpgt_ps(uvArea, zero), _mm_set1_ps(-1.f)));
+
+						__m128 tangent[3];
+						for (int axis = 0; axis < 3; ++axis)
+							tangent[axis] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(edge0[axis], diffYy), _mm_mul_ps(edge1[axis], diffYx)), sign);
+
+						const auto magnitude = [](const __m128* v)
+						{
+							return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(v[0], v[0]), _mm_mul_ps(v[1], v[1])), _mm_mul_ps(v[2], v[2])));
+						};
+						const auto dot = [](const __m128* a, const __m128* b)
+						{
+							return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_mul_ps(a[2], b[2]));
+						};
+
+						// a zero length or UV area leaves the tangent at zero
+						const __m128 tangentLength = magnitude(tangent);
+						const __m128 hasTangent = _mm_and_ps(_mm_cmpgt_ps(tangentLength, zero), _mm_cmpneq_ps(uvArea, zero));
+						alignas(16) float tangents[3][4];
+						for (int axis = 0; axis < 3; ++axis)
+							_mm_store_ps(tangents[axis], _mm_and_ps(_mm_div_ps(tangent[axis], tangentLength), hasTangent));
+
+						// corner 1 and 2 use negated edges, that only flips the sign of their dot products
+						const __m128 length0 = magnitude(edge0);
+						const __m128 length1 = magnitude(edge1);
+						const __m128 length2 = magnitude(edge2);
+						const __m128 cornerLengths[3]{ _mm_mul_ps(length0, length1), _mm_mul_ps(length0, length2), _mm_mul_ps(length1, length2) };
+						const __m128 cornerDots[3]{ dot(edge0, edge1), _mm_sub_ps(zero, dot(edge0, edge2)), dot(edge1, edge2) };
+
+						alignas(16) float cosines[3][4];
+						alignas(16) float hasAngle[3][4];
+						for (int corner = 0; corner < 3; ++corner)
+						{
+							const __m128 cosine = _mm_div_ps(cornerDots[corner], cornerLengths[corner]);
+							_mm_store_ps(cosines[corner], _mm_min_ps(_mm_max_ps(cosine, _mm_set1_ps(-1.f)), one));
+							_mm_store_ps(hasAngle[corner], _mm_and_ps(_mm_cmpgt_ps(cornerLengths[corner], zero), one));
+						}
+
+						alignas(16) float areas[4];
+						_mm_store_ps(areas, uvArea);
+						for (int lane = 0; lane < 4; ++lane)
+						{
+							const size_t triangle = t + lane;
+							triangleTangents[triangle] = Vector3{ tangents[0][lane], tangents[1][lane], tangents[2][lane] };
+							if (areas[lane] == 0.f)
+								continue;
+
+							for (int corner = 0; corner < 3; ++corner)
+								cornerWeights[triangle * 3 + corner] = hasAngle[corner][lane] != 0.f ? std::acos(cosines[corner][lane]) : 0.f;
+						}
+					}
+
+					for (; t < end; ++t)
+						calculateTriangle(t);
+				});
+
+			// Vertex -> triangle corner adjacency (CSR), so the gather below only writes its own vertex
+			std::vector<uint32_t> cornerOffsets(vertices.size() + 1, 0);
+			for (const uint32_t index : indices)
+				++cornerOffsets[index + 1];
+			for (size_t i = 1; i < cornerOffsets.size(); ++i)
+				cornerOffsets[i] += cornerOffsets[i - 1];
+
+			std::vector<uint32_t> vertexCorners(nrTriangles * 3);
+			{
+				std::vector<uint32_t> fillPosition(cornerOffsets.begin(), cornerOffsets.end() - 1);
+				for (size_t corner = 0; corner < nrTriangles * 3; ++corner)
+					vertexCorners[fillPosition[indices[corner]]++] = static_cast<uint32_t>(corner);
+			}
+
+			parallelFor(vertices.size(), [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						Vertex& v = vertices[i];
+
+						Vector3 tangent{};
+						for (uint32_t c = cornerOffsets[i]; c < cornerOffsets[i + 1]; ++c)
+						{
+							const uint32_t corner = vertexCorners[c];
+							tangent += triangleTangents[corner / 3] * cornerWeights[corner];
+						}
+
+						tangent = Vector3::Reject(tangent, v.normal);
+
+						// Nothing usable accumulated: any direction perpendicular to the normal will do
+						if (tangent.SqrMagnitude() <= FLT_MIN)
+						{
+							const Vector3 axis = std::abs(v.normal.x) < 0.9f ? Vector3::UnitX : Vector3::UnitY;
+							tangent = Vector3::Reject(axis, v.normal);
+						}
+
+						v.tangent = tangent.Normalized();
+					}
+				});
+		}
+
+		//Parses the materials of an MTL file, texture paths are made relative to the working directory
+		static bool ParseMTL(const std::string& filename, std::vector<Material>& materials)
+		{
+			std::ifstream file(filename);
+			if (!file)
+				return false;
+
+			const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+
+			// map statements can carry options (-bm 1.0 ...), the file name is always the last token
+			const auto readMapPath = [&file, &directory]()
+			{
+				std::string line;
+				std::getline(file, line);
+
+				const size_t end = line.find_last_not_of(" \t\r");
+				const size_t begin = line.find_last_of(" \t", end);
+				const std::string fileName = end == std::string::npos ? std::string{} : line.substr(begin + 1, end - begin);
+
+				return fileName.empty() ? fileName : (directory / fileName).lexically_normal().generic_string();
+			};
+
+			std::string sCommand;
+			while (file >> sCommand)
+			{
+				if (sCommand == "newmtl")
+				{
+					materials.emplace_back();
+					file >> materials.back().name;
+				}
+				else if (materials.empty())
+				{
+					// Statements before the first newmtl don't belong to anything
+				}
+				else if (sCommand == "map_Kd")
+				{
+					materials.back().diffuseMap = readMapPath();
+					continue;
+				}
+				else if (sCommand == "map_Bump" || sCommand == "map_bump" || sCommand == "bump" || sCommand == "norm")
+				{
+					materials.back().normalMap = readMapPath();
+					continue;
+				}
+				else if (sCommand == "map_Ns")
+				{
+					materials.back().glossinessMap = readMapPath();
+					continue;
+				}
+				else if (sCommand == "map_Ks")
+				{
+					materials.back().specularMap = readMapPath();
+					continue;
+				}
+				//read till end of line and ignore all remaining chars
+				file.ignore(1000, '\n');
+			}
+
+			return true;
+		}
+
+		//Batch of parsed triangles, indices and sub mesh offsets are relative to the batch.
+		//Sub mesh material indices point in the list of all materials handed over so far.
+		struct MeshChunk
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			std::vector<SubMesh> subMeshes{};
+			std::vector<Material> newMaterials{};
+		};
+
+		//Called for every parsed batch of triangles. Return false to stop parsing.
+		using MeshChunkCallback = std::function<bool(MeshChunk&& chunk)>;
+
+		//Parses vertices and indices, handing them over in batches of (at most) trianglesPerChunk triangles.
+		//OBJ faces never share vertices, so every batch is self-contained (tangents included).
+		static bool ParseOBJChunked(const std::string& filename, size_t trianglesPerChunk, const MeshChunkCallback& onChunk, bool flipAxisAndWinding = true, ThreadPool* pThreadPool = nullptr)
 		{
 #ifdef DISABLE_OBJ
 			
 			// >> Comment/Remove '#define DISABLE_OBJ'
-			assert(false && "OBJ PARSER not enabled! Check the comments in Utils::ParseOBJ");
+			assert(false && "OBJ PARSER not enabled! Check the comments in Utils::ParseOBJChunked");
 
 #else
 
@@ -30,8 +306,40 @@ namespace dae
 			std::vector<Vector3> normals{};
 			std::vector<Vector2> UVs{};
 
-			vertices.clear();
-			indices.clear();
+			MeshChunk chunk{};
+			std::vector<Vertex>& vertices = chunk.vertices;
+			std::vector<uint32_t>& indices = chunk.indices;
+
+			// usemtl refers to materials by name, sub meshes by index in everything handed over
+			std::vector<std::string> materialNames{};
+			uint32_t currentMaterial{ SubMesh::NoMaterial };
+
+			const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+
+			//Finishes the current batch and hands it over
+			const auto flushChunk = [&]() -> bool
+			{
+				if (indices.empty() && chunk.newMaterials.empty())
+					return true;
+
+				CalculateTangents(vertices, indices, pThreadPool);
+
+				if (flipAxisAndWinding)
+				{
+					for (auto& v : vertices)
+					{
+						v.position.z *= -1.f;
+						v.normal.z *= -1.f;
+						v.tangent.z *= -1.f;
+					}
+				}
+
+				const bool keepParsing = onChunk(std::move(chunk));
+
+				chunk = MeshChunk{};
+
+				return keepParsing;
+			};
 
 			std::string sCommand;
 			// start a while iteration ending when the end of file is reached (ios::eof)
@@ -44,6 +352,29 @@ namespace dae
 				{
 					// Ignore Comment
 				}
+				else if (sCommand == "mtllib")
+				{
+					std::string mtlFile;
+					file >> mtlFile;
+
+					const size_t firstNewMaterial = chunk.newMaterials.size();
+					ParseMTL((directory / mtlFile).string(), chunk.newMaterials);
+
+					for (size_t i = firstNewMaterial; i < chunk.newMaterials.size(); ++i)
+						materialNames.push_back(chunk.newMaterials[i].name);
+
+					// hand the materials over right away, so their textures can load while we parse
+					if (!flushChunk())
+						return true;
+				}
+				else if (sCommand == "usemtl")
+				{
+					std::string materialName;
+					file >> materialName;
+
+					const auto it = std::find(materialNames.begin(), materialNames.end(), materialName);
+					currentMaterial = it == materialNames.end() ? SubMesh::NoMaterial : static_cast<uint32_t>(it - materialNames.begin());
+				}
 				else if (sCommand == "v")
 				{
 					//Vertex
@@ -111,6 +442,11 @@ namespace dae
 						//indices.push_back(uint32_t(vertices.size()) - 1);
 					}
 
+					// a new material (or batch) starts a new sub mesh
+					if (chunk.subMeshes.empty() || chunk.subMeshes.back().materialIndex != currentMaterial)
+						chunk.subMeshes.push_back({ static_cast<uint32_t>(indices.size()), 0, currentMaterial });
+					chunk.subMeshes.back().indexCount += 3;
+
 					indices.push_back(tempIndices[0]);
 					if (flipAxisAndWinding) 
 					{
@@ -122,50 +458,15 @@ namespace dae
 						indices.push_back(tempIndices[1]);
 						indices.push_back(tempIndices[2]);
 					}
+
+					if (indices.size() / 3 >= trianglesPerChunk && !flushChunk())
+						return true;
 				}
 				//read till end of line and ignore all remaining chars
 				file.ignore(1000, '\n');
 			}
 
-			//Cheap Tangent Calculations
-			for (uint32_t i = 0; i < indices.size(); i += 3)
-			{
-				uint32_t index0 = indices[i];
-				uint32_t index1 = indices[size_t(i) + 1];
-				uint32_t index2 = indices[size_t(i) + 2];
-
-				const Vector3& p0 = vertices[index0].position;
-				const Vector3& p1 = vertices[index1].position;
-				const Vector3& p2 = vertices[index2].position;
-				const Vector2& uv0 = vertices[index0].uv;
-				const Vector2& uv1 = vertices[index1].uv;
-				const Vector2& uv2 = vertices[index2].uv;
-
-				const Vector3 edge0 = p1 - p0;
-				const Vector3 edge1 = p2 - p0;
-				const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
-				const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
-				float r = 1.f / Vector2::Cross(diffX, diffY);
-
-				Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
-				vertices[index0].tangent += tangent;
-				vertices[index1].tangent += tangent;
-				vertices[index2].tangent += tangent;
-			}
-
-			//Fix the tangents per vertex now because we accumulated
-			for (auto& v : vertices)
-			{
-				v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
-
-				if(flipAxisAndWinding)
-				{
-					v.position.z *= -1.f;
-					v.normal.z *= -1.f;
-					v.tangent.z *= -1.f;
-				}
-
-			}
+			flushChunk();
 
 			return true;
 #endif
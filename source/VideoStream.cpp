@@ -0,0 +1,178 @@
+#include "VideoStream.h"
+#include "RenderTarget.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace dae
+{
+	VideoStream::~VideoStream()
+	{
+		Close();
+	}
+
+	bool VideoStream::Open(const std::string& path, VideoFormat format, int width, int height, int framesPerSecond)
+	{
+		Close();
+
+		if (path == "-")
+		{
+#ifdef _WIN32
+			// don't let the CRT turn \n into \r\n inside the frames
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+			m_pFile = stdout;
+			m_OwnsFile = false;
+		}
+		else
+		{
+			// a named pipe is opened like any other file, this blocks until the reader connects
+			m_pFile = std::fopen(path.c_str(), "wb");
+			m_OwnsFile = true;
+		}
+
+		if (!m_pFile)
+			return false;
+
+		m_Format = format;
+		m_Width = width;
+		m_Height = height;
+		m_HasFailed = false;
+		m_IsStopping = false;
+		m_NextBuffer = 0;
+
+		for (int i{}; i < NrBuffers; ++i)
+		{
+			m_Buffers[i].resize(size_t(width) * height * 3);
+			m_IsBufferInFlight[i] = false;
+		}
+
+		if (m_Format == VideoFormat::Y4M)
+		{
+			if (std::fprintf(m_pFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, framesPerSecond) < 0)
+				m_HasFailed = true;
+		}
+
+		m_Thread = std::thread(&VideoStream::WriterLoop, this);
+		return !m_HasFailed;
+	}
+
+	void VideoStream::Close()
+	{
+		if (!m_pFile)
+			return;
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_Condition.notify_all();
+		m_Thread.join();
+
+		std::fflush(m_pFile);
+		if (m_OwnsFile)
+			std::fclose(m_pFile);
+		m_pFile = nullptr;
+	}
+
+	bool VideoStream::Submit(const RenderTarget& renderTarget)
+	{
+		if (!m_pFile || renderTarget.GetWidth() != m_Width || renderTarget.GetHeight() != m_Height)
+			return false;
+
+		const int bufferIndex = m_NextBuffer;
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_Condition.wait(lock, [this, bufferIndex]() { return !m_IsBufferInFlight[bufferIndex] || m_HasFailed; });
+			if (m_HasFailed)
+				return false;
+		}
+
+		// the writer only touches buffers in flight, this one is ours until it's queued
+		ConvertFrame(renderTarget.GetColorBuffer(), m_Buffers[bufferIndex]);
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsBufferInFlight[bufferIndex] = true;
+			m_QueuedBuffers.push_back(bufferIndex);
+		}
+		m_Condition.notify_all();
+
+		m_NextBuffer = (m_NextBuffer + 1) % NrBuffers;
+		return true;
+	}
+
+	bool VideoStream::HasFailed() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_HasFailed;
+	}
+
+	void VideoStream::WriterLoop()
+	{
+		std::unique_lock lock{ m_Mutex };
+		while (true)
+		{
+			m_Condition.wait(lock, [this]() { return m_IsStopping || !m_QueuedBuffers.empty(); });
+
+			// write out what's queued before stopping
+			if (m_QueuedBuffers.empty())
+				return;
+
+			const int bufferIndex = m_QueuedBuffers.front();
+			m_QueuedBuffers.pop_front();
+			const bool hasFailed = m_HasFailed;
+			lock.unlock();
+
+			bool succeeded = !hasFailed;
+			if (succeeded && m_Format == VideoFormat::Y4M)
+				succeeded = std::fputs("FRAME\n", m_pFile) >= 0;
+			if (succeeded)
+			{
+				const std::vector<uint8_t>& buffer = m_Buffers[bufferIndex];
+				succeeded = std::fwrite(buffer.data(), 1, buffer.size(), m_pFile) == buffer.size();
+			}
+
+			lock.lock();
+			m_IsBufferInFlight[bufferIndex] = false;
+			if (!succeeded)
+				m_HasFailed = true;
+			m_Condition.notify_all();
+		}
+	}
+
+	void VideoStream::ConvertFrame(const uint32_t* pPixels, std::vector<uint8_t>& buffer) const
+	{
+		const size_t nrPixels = size_t(m_Width) * m_Height;
+
+		if (m_Format == VideoFormat::RawRGB)
+		{
+			uint8_t* pOut = buffer.data();
+			for (size_t i{}; i < nrPixels; ++i)
+			{
+				const uint32_t pixel = pPixels[i]; // ARGB8888
+				pOut[i * 3 + 0] = uint8_t(pixel >> 16);
+				pOut[i * 3 + 1] = uint8_t(pixel >> 8);
+				pOut[i * 3 + 2] = uint8_t(pixel);
+			}
+			return;
+		}
+
+		// Y4M is planar: all Y, then all U (Cb), then all V (Cr), studio range BT.601
+		uint8_t* pY = buffer.data();
+		uint8_t* pU = pY + nrPixels;
+		uint8_t* pV = pU + nrPixels;
+		for (size_t i{}; i < nrPixels; ++i)
+		{
+			const int r = int(pPixels[i] >> 16) & 0xff;
+			const int g = int(pPixels[i] >> 8) & 0xff;
+			const int b = int(pPixels[i]) & 0xff;
+
+			pY[i] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+			pU[i] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+			pV[i] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class RenderTarget;
+
+	enum class VideoFormat
+	{
+		RawRGB, //packed 8 bit RGB frames back to back, e.g. ffmpeg -f rawvideo -pixel_format rgb24 -video_size WxH -i -
+		Y4M //YUV4MPEG2, 4:4:4 BT.601, the header carries size and frame rate
+	};
+
+	//Streams uncompressed frames to stdout ("-"), a named pipe or a file, for ffmpeg or a video player to pick up.
+	//Two output buffers are rotated: Submit converts straight into the free one and hands it to the writer thread,
+	//so the render thread only waits when the consumer falls two frames behind.
+	class VideoStream final
+	{
+	public:
+		VideoStream() = default;
+		~VideoStream();
+
+		VideoStream(const VideoStream&) = delete;
+		VideoStream(VideoStream&&) noexcept = delete;
+		VideoStream& operator=(const VideoStream&) = delete;
+		VideoStream& operator=(VideoStream&&) noexcept = delete;
+
+		bool Open(const std::string& path, VideoFormat format, int width, int height, int framesPerSecond = 30);
+		//Writes out the frames in flight and closes the output
+		void Close();
+
+		//Every frame has to match the size passed to Open. Returns false once a write has failed
+		bool Submit(const RenderTarget& renderTarget);
+
+		bool HasFailed() const;
+
+	private:
+		static constexpr int NrBuffers{ 2 };
+
+		std::FILE* m_pFile{};
+		bool m_OwnsFile{ false };
+		VideoFormat m_Format{};
+		int m_Width{};
+		int m_Height{};
+
+		std::vector<uint8_t> m_Buffers[NrBuffers]{};
+		bool m_IsBufferInFlight[NrBuffers]{};
+		int m_NextBuffer{};
+
+		std::thread m_Thread{};
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		std::deque<int> m_QueuedBuffers{};
+		bool m_IsStopping{ false };
+		bool m_HasFailed{ false };
+
+		void WriterLoop();
+		void ConvertFrame(const uint32_t* pPixels, std::vector<uint8_t>& buffer) const;
+	};
+}
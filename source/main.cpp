@@ -1,15 +1,28 @@
 //External includes
+#ifdef _WIN32
 #include "vld.h"
+#endif
 #include "SDL.h"
 #include "SDL_surface.h"
+#include "SDL_image.h"
 #undef main
 
 //Standard includes
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
+#include <string>
 
 //Project includes
 #include "Timer.h"
 #include "Renderer.h"
+#include "CameraPath.h"
+#include "FrameWriter.h"
+#include "VideoStream.h"
+#include "Profiler.h"
+#include "ImageCompare.h"
+#include "RenderTarget.h"
 
 using namespace dae;
 
@@ -19,23 +32,390 @@ void ShutDown(SDL_Window* pWindow)
 	SDL_Quit();
 }
 
+void PrintStatistics(const PipelineStatistics& statistics)
+{
+	std::cout << "Triangles: " << statistics.nrInputTriangles
+		<< " (frustum culled " << statistics.nrFrustumCulledTriangles
+		<< ", back-face culled " << statistics.nrBackFaceCulledTriangles
+		<< ", off screen " << statistics.nrOffScreenTriangles << ")\n"
+		<< "Pixels: " << statistics.nrPixelsTested << " tested, " << statistics.nrPixelsAccepted << " accepted in whole blocks, "
+		<< statistics.nrPixelsCovered << " covered ("
+		<< statistics.GetCoverageRatio() * 100.f << "% of tested), depth " << statistics.nrDepthTestsPassed << " passed / "
+		<< statistics.nrDepthTestsFailed << " failed, " << statistics.nrPixelShaderInvocations << " shaded" << std::endl;
+}
+
+//Renders a number of frames without a window or display, the last one is saved
+int RunHeadless(int argc, char* args[])
+{
+	const int nrFrames = argc > 2 ? std::stoi(args[2]) : 100;
+	const int width = argc > 4 ? std::stoi(args[3]) : 640;
+	const int height = argc > 4 ? std::stoi(args[4]) : 480;
+	const std::string tracePath = argc > 5 ? args[5] : "";
+
+	const auto pTimer = new Timer();
+	const auto pRenderer = new Renderer(width, height);
+
+	//Wait for the streamed mesh, we want every frame to be complete
+	pRenderer->WaitForLoading();
+	if (pRenderer->HasLoadingFailed())
+	{
+		std::cout << "Couldn't load the mesh" << std::endl;
+		delete pRenderer;
+		delete pTimer;
+		return 1;
+	}
+	pRenderer->Update(pTimer);
+
+	if (!tracePath.empty())
+	{
+		Profiler::GetInstance().SetEnabled(true);
+		Profiler::GetInstance().BeginCapture();
+	}
+
+	pTimer->Start();
+	float totalTime = 0.f;
+	for (int frame{}; frame < nrFrames; ++frame)
+	{
+		pRenderer->Update(pTimer);
+		pRenderer->Render();
+
+		pTimer->Update();
+		totalTime += pTimer->GetElapsed();
+	}
+	pTimer->Stop();
+
+	std::cout << nrFrames << " frames (" << width << "x" << height << ") in " << totalTime << "s, "
+		<< (totalTime > 0.f ? nrFrames / totalTime : 0.f) << " FPS" << std::endl;
+	PrintStatistics(pRenderer->GetStatistics());
+
+	bool failed = false;
+	if (!tracePath.empty())
+	{
+		failed = !Profiler::GetInstance().EndCapture(tracePath);
+		std::cout << (failed ? "Failed to write " : "Trace written to ") << tracePath << std::endl;
+	}
+
+	failed |= pRenderer->SaveBufferToImage();
+
+	delete pRenderer;
+	delete pTimer;
+
+	return failed ? 1 : 0;
+}
+
+//Renders a camera path into numbered images as fast as possible, no events are polled
+//and the mesh doesn't animate. Images are written on a background thread.
+int RunBatch(int argc, char* args[])
+{
+	if (argc < 5)
+	{
+		std::cout << "Usage: Rasterizer --batch <scene> <keyframes> <outputDir> [frames] [width height] [bmp|png|qoi|raw]" << std::endl;
+		return 1;
+	}
+
+	const std::string scenePath{ args[2] };
+	const std::string outputDir{ args[4] };
+	const int nrFrames = argc > 5 ? std::stoi(args[5]) : 100;
+	const int width = argc > 7 ? std::stoi(args[6]) : 640;
+	const int height = argc > 7 ? std::stoi(args[7]) : 480;
+	const ImageFormat format = FrameWriter::GetFormatFromPath(argc > 8 ? std::string{ "frame." } + args[8] : "frame.bmp");
+
+	CameraPath cameraPath{};
+	if (!cameraPath.LoadFromFile(args[3]))
+	{
+		std::cout << "Couldn't load camera keyframes from " << args[3] << std::endl;
+		return 1;
+	}
+
+	std::error_code error{};
+	std::filesystem::create_directories(outputDir, error);
+	if (error)
+	{
+		std::cout << "Couldn't create " << outputDir << ": " << error.message() << std::endl;
+		return 1;
+	}
+
+	const auto pTimer = new Timer();
+	const auto pRenderer = new Renderer(width, height, scenePath);
+
+	pRenderer->WaitForLoading();
+	if (pRenderer->HasLoadingFailed())
+	{
+		std::cout << "Couldn't load " << scenePath << std::endl;
+		delete pRenderer;
+		delete pTimer;
+		return 1;
+	}
+
+	FrameWriter frameWriter{};
+
+	pTimer->Start();
+	const float startTime = cameraPath.GetStartTime();
+	const float duration = cameraPath.GetEndTime() - startTime;
+	for (int frame{}; frame < nrFrames; ++frame)
+	{
+		// first and last frame land exactly on the first and last key
+		const float time = startTime + (nrFrames > 1 ? duration * frame / (nrFrames - 1) : 0.f);
+		const CameraKeyframe keyframe = cameraPath.Sample(time);
+		pRenderer->SetCameraTransform(keyframe.origin, keyframe.pitch, keyframe.yaw);
+
+		pRenderer->Render();
+
+		char fileName[32]{};
+		std::snprintf(fileName, sizeof(fileName), "frame_%04d%s", frame, FrameWriter::GetExtension(format));
+		frameWriter.Submit(pRenderer->GetRenderTarget(), (std::filesystem::path{ outputDir } / fileName).string());
+	}
+	frameWriter.Flush();
+	pTimer->Update();
+	pTimer->Stop();
+
+	const float totalTime = pTimer->GetElapsed();
+	std::cout << nrFrames << " frames (" << width << "x" << height << ") written to " << outputDir << " in " << totalTime << "s, "
+		<< (totalTime > 0.f ? nrFrames / totalTime : 0.f) << " frames/s" << std::endl;
+
+	const size_t nrFailedWrites = frameWriter.GetNrFailedWrites();
+	if (nrFailedWrites > 0)
+		std::cout << nrFailedWrites << " frames couldn't be written" << std::endl;
+
+	delete pRenderer;
+	delete pTimer;
+
+	return nrFailedWrites > 0 ? 1 : 0;
+}
+
+//Streams a camera path as uncompressed video, e.g.
+//Rasterizer --stream Resources/vehicle.obj path.txt - 300 640 480 y4m | ffmpeg -i - out.mp4
+//Stdout may carry the video, so everything else goes to stderr
+int RunStream(int argc, char* args[])
+{
+	if (argc < 5)
+	{
+		std::cerr << "Usage: Rasterizer --stream <scene> <keyframes> <output|-> [frames] [width height] [rgb|y4m] [fps]" << std::endl;
+		return 1;
+	}
+
+	const std::string scenePath{ args[2] };
+	const std::string outputPath{ args[4] };
+	const int nrFrames = argc > 5 ? std::stoi(args[5]) : 100;
+	const int width = argc > 7 ? std::stoi(args[6]) : 640;
+	const int height = argc > 7 ? std::stoi(args[7]) : 480;
+	const VideoFormat format = argc > 8 && std::string{ args[8] } == "rgb" ? VideoFormat::RawRGB : VideoFormat::Y4M;
+	const int framesPerSecond = argc > 9 ? std::stoi(args[9]) : 30;
+
+	CameraPath cameraPath{};
+	if (!cameraPath.LoadFromFile(args[3]))
+	{
+		std::cerr << "Couldn't load camera keyframes from " << args[3] << std::endl;
+		return 1;
+	}
+
+	const auto pTimer = new Timer();
+	const auto pRenderer = new Renderer(width, height, scenePath);
+
+	pRenderer->WaitForLoading();
+	if (pRenderer->HasLoadingFailed())
+	{
+		std::cerr << "Couldn't load " << scenePath << std::endl;
+		delete pRenderer;
+		delete pTimer;
+		return 1;
+	}
+
+	VideoStream videoStream{};
+	if (!videoStream.Open(outputPath, format, width, height, framesPerSecond))
+	{
+		std::cerr << "Couldn't open " << outputPath << " for streaming" << std::endl;
+		delete pRenderer;
+		delete pTimer;
+		return 1;
+	}
+
+	pTimer->Start();
+	const float startTime = cameraPath.GetStartTime();
+	const float duration = cameraPath.GetEndTime() - startTime;
+	int frame{};
+	for (; frame < nrFrames; ++frame)
+	{
+		const float time = startTime + (nrFrames > 1 ? duration * frame / (nrFrames - 1) : 0.f);
+		const CameraKeyframe keyframe = cameraPath.Sample(time);
+		pRenderer->SetCameraTransform(keyframe.origin, keyframe.pitch, keyframe.yaw);
+
+		pRenderer->Render();
+
+		// the reader went away
+		if (!videoStream.Submit(pRenderer->GetRenderTarget()))
+			break;
+	}
+	videoStream.Close();
+	pTimer->Update();
+	pTimer->Stop();
+
+	const bool hasFailed = videoStream.HasFailed();
+	const float totalTime = pTimer->GetElapsed();
+	std::cerr << frame << " frames (" << width << "x" << height << ") streamed in " << totalTime << "s, "
+		<< (totalTime > 0.f ? frame / totalTime : 0.f) << " frames/s" << (hasFailed ? ", the output was closed early" : "") << std::endl;
+
+	delete pRenderer;
+	delete pTimer;
+
+	return hasFailed ? 1 : 0;
+}
+
+//Compares the current frame with <goldenDir>/<name>.png, or replaces that image when updating.
+//Failed frames are written to outputDir next to a diff image
+bool CheckGoldenImage(const Renderer& renderer, std::string name, const std::string& goldenDir, const std::string& outputDir, bool isUpdating)
+{
+	// differences a different compiler or instruction set may cause, still far from anything visible
+	constexpr int PixelTolerance{ 4 };
+	constexpr double MaxShareOverTolerance{ 0.001 };
+	constexpr double MinPsnr{ 40.0 };
+
+	std::replace(name.begin(), name.end(), ' ', '_');
+	const std::string goldenPath = (std::filesystem::path{ goldenDir } / (name + ".png")).string();
+
+	SDL_Surface* pFrame = renderer.GetRenderTarget().GetSurface();
+	if (isUpdating)
+	{
+		const bool isSaved = IMG_SavePNG(pFrame, goldenPath.c_str()) == 0;
+		std::cout << (isSaved ? "Updated " : "Couldn't write ") << goldenPath << std::endl;
+		return isSaved;
+	}
+
+	SDL_Surface* pLoadedGolden = IMG_Load(goldenPath.c_str());
+	if (!pLoadedGolden)
+	{
+		std::cout << name << ": FAILED, couldn't load " << goldenPath << std::endl;
+		return false;
+	}
+
+	// the png is loaded as RGB24 or RGBA
+	SDL_Surface* pGolden = SDL_ConvertSurfaceFormat(pLoadedGolden, SDL_PIXELFORMAT_ARGB8888, 0);
+	SDL_FreeSurface(pLoadedGolden);
+
+	if (!pGolden || pGolden->w != pFrame->w || pGolden->h != pFrame->h)
+	{
+		std::cout << name << ": FAILED, the golden image has a different size" << std::endl;
+		SDL_FreeSurface(pGolden);
+		return false;
+	}
+
+	SDL_Surface* pDiff = SDL_CreateRGBSurfaceWithFormat(0, pFrame->w, pFrame->h, 32, SDL_PIXELFORMAT_ARGB8888);
+
+	// render targets and converted surfaces are tightly packed
+	const ImageDifference difference = CompareImages(static_cast<const uint32_t*>(pFrame->pixels), static_cast<const uint32_t*>(pGolden->pixels),
+		pFrame->w, pFrame->h, PixelTolerance, static_cast<uint32_t*>(pDiff->pixels));
+	SDL_FreeSurface(pGolden);
+
+	const bool hasPassed = difference.nrPixelsOverTolerance <= int(MaxShareOverTolerance * pFrame->w * pFrame->h)
+		&& difference.psnr >= MinPsnr;
+
+	std::cout << name << ": " << (hasPassed ? "passed" : "FAILED") << ", PSNR " << difference.psnr << " dB, "
+		<< difference.nrPixelsOverTolerance << " pixels over tolerance, max difference " << difference.maxDifference << std::endl;
+
+	if (!hasPassed)
+	{
+		const std::string outputPath = (std::filesystem::path{ outputDir } / name).string();
+		IMG_SavePNG(pFrame, (outputPath + "_actual.png").c_str());
+		IMG_SavePNG(pDiff, (outputPath + "_diff.png").c_str());
+	}
+
+	SDL_FreeSurface(pDiff);
+	return hasPassed;
+}
+
+//Renders one frame per shading mode and per display mode and checks them against golden images.
+//Updating writes the golden images instead
+int RunGolden(int argc, char* args[])
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: Rasterizer --golden <goldenDir> [outputDir|--update]" << std::endl;
+		return 1;
+	}
+
+	// small enough to keep the golden images in the repository
+	constexpr int Width{ 320 };
+	constexpr int Height{ 240 };
+
+	const std::string goldenDir{ args[2] };
+	const bool isUpdating = argc > 3 && std::string{ args[3] } == "--update";
+	const std::string outputDir = argc > 3 && !isUpdating ? args[3] : "GoldenFailures";
+
+	std::error_code error{};
+	std::filesystem::create_directories(isUpdating ? goldenDir : outputDir, error);
+
+	const auto pRenderer = new Renderer(Width, Height);
+
+	pRenderer->WaitForLoading();
+	if (pRenderer->HasLoadingFailed())
+	{
+		std::cout << "Couldn't load the mesh" << std::endl;
+		delete pRenderer;
+		return 1;
+	}
+
+	int nrFailed{};
+
+	// starts at the final color with combined shading, cycling every mode once ends there again
+	for (int shadingMode{}; shadingMode < 4; ++shadingMode)
+	{
+		pRenderer->ToggleShadingMode();
+		pRenderer->Render();
+
+		if (!CheckGoldenImage(*pRenderer, std::string{ pRenderer->GetDisplayModeName() } + " " + pRenderer->GetShadingModeName(), goldenDir, outputDir, isUpdating))
+			++nrFailed;
+	}
+
+	// raster time changes every run, it isn't checked
+	for (int displayMode{ 1 }; displayMode < 4; ++displayMode)
+	{
+		pRenderer->ToggleDisplayMode();
+		pRenderer->Render();
+
+		if (!CheckGoldenImage(*pRenderer, pRenderer->GetDisplayModeName(), goldenDir, outputDir, isUpdating))
+			++nrFailed;
+	}
+
+	delete pRenderer;
+
+	if (!isUpdating)
+		std::cout << (nrFailed == 0 ? "All golden images match" : "Golden images that differ: " + std::to_string(nrFailed) + ", see " + outputDir) << std::endl;
+
+	return nrFailed == 0 ? 0 : 1;
+}
+
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	//Rasterizer --headless [frames] [width height] [trace.json]
+	if (argc > 1 && std::string{ args[1] } == "--headless")
+		return RunHeadless(argc, args);
+	//Rasterizer --batch <scene> <keyframes> <outputDir> [frames] [width height] [bmp|png|qoi|raw]
+	if (argc > 1 && std::string{ args[1] } == "--batch")
+		return RunBatch(argc, args);
+	//Rasterizer --stream <scene> <keyframes> <output|-> [frames] [width height] [rgb|y4m] [fps]
+	if (argc > 1 && std::string{ args[1] } == "--stream")
+		return RunStream(argc, args);
+	//Rasterizer --golden <goldenDir> [outputDir|--update]
+	if (argc > 1 && std::string{ args[1] } == "--golden")
+		return RunGolden(argc, args);
 
+#ifdef RASTERIZER_HEADLESS
+	//Built without the window loop, see CMakeLists.txt
+	std::cout << "Usage: " << args[0] << " --headless|--batch|--stream|--golden ..." << std::endl;
+	return 1;
+#else
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
 
-	const uint32_t width = 640;
-	const uint32_t height = 480;
+	//Rasterizer [width height]
+	const int width = argc > 2 ? std::stoi(args[1]) : 640;
+	const int height = argc > 2 ? std::stoi(args[2]) : 480;
 
 	SDL_Window* pWindow = SDL_CreateWindow(
 		"Rasterizer - **Dewachtere Michiel**",
 		SDL_WINDOWPOS_UNDEFINED,
 		SDL_WINDOWPOS_UNDEFINED,
-		width, height, 0);
+		width, height, SDL_WINDOW_RESIZABLE);
 
 	if (!pWindow)
 		return 1;
@@ -49,9 +429,12 @@ int main(int argc, char* args[])
 	float printTimer = 0.f;
 	bool isLooping = true;
 	bool takeScreenshot = false;
+	int nrFramesToTrace = 0;
 	while (isLooping)
 	{
 		//--------- Get input events ---------
+		// the present thread can't use the window surface while events may recreate it
+		pRenderer->PausePresenting();
 		SDL_Event e;
 		while (SDL_PollEvent(&e))
 		{
@@ -60,20 +443,60 @@ int main(int argc, char* args[])
 			case SDL_QUIT:
 				isLooping = false;
 				break;
+			case SDL_WINDOWEVENT:
+				if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+					pRenderer->Resize(e.window.data1, e.window.data2);
+				break;
 			case SDL_KEYUP:
 				if (e.key.keysym.scancode == SDL_SCANCODE_X)
 					takeScreenshot = true;
 				else if (e.key.keysym.scancode == SDL_SCANCODE_F4)
+				{
 					pRenderer->ToggleDisplayMode();
+					std::cout << "Display mode " << pRenderer->GetDisplayModeName() << std::endl;
+				}
 				else if (e.key.keysym.scancode == SDL_SCANCODE_F5)
 					pRenderer->ToggleMeshRotation();
 				else if (e.key.keysym.scancode == SDL_SCANCODE_F6)
 					pRenderer->ToggleNormalMap();
 				else if (e.key.keysym.scancode == SDL_SCANCODE_F7)
+				{
 					pRenderer->ToggleShadingMode();
+					std::cout << "Shading mode " << pRenderer->GetShadingModeName() << std::endl;
+				}
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+				{
+					pRenderer->ToggleReversedZ();
+					std::cout << "Reversed-Z " << (pRenderer->IsReversedZ() ? "on" : "off") << std::endl;
+				}
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F9)
+				{
+					constexpr const char* depthFormatNames[]{ "float32", "unorm24", "unorm16" };
+					const DepthFormat depthFormat = DepthFormat{ ((int)pRenderer->GetDepthFormat() + 1) % 3 };
+					pRenderer->SetDepthFormat(depthFormat);
+					std::cout << "Depth format " << depthFormatNames[(int)depthFormat] << std::endl;
+				}
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F10)
+				{
+					pRenderer->SetDynamicResolution(!pRenderer->IsDynamicResolution());
+					std::cout << "Dynamic resolution " << (pRenderer->IsDynamicResolution() ? "on" : "off") << std::endl;
+				}
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F11)
+				{
+					Profiler::GetInstance().SetEnabled(!Profiler::GetInstance().IsEnabled());
+					nrFramesToTrace = 0;
+					std::cout << "Profiler " << (Profiler::GetInstance().IsEnabled() ? "on" : "off") << std::endl;
+				}
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F12 && nrFramesToTrace == 0)
+				{
+					Profiler::GetInstance().SetEnabled(true);
+					Profiler::GetInstance().BeginCapture();
+					nrFramesToTrace = 60;
+				}
 				break;
 			}
 		}
+		pRenderer->ResumePresenting();
 
 		//--------- Update ---------
 		pRenderer->Update(pTimer);
@@ -87,16 +510,37 @@ int main(int argc, char* args[])
 		if (printTimer >= 1.f)
 		{
 			printTimer = 0.f;
-			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+			std::cout << "dFPS: " << pTimer->GetdFPS();
+			if (pRenderer->IsDynamicResolution())
+				std::cout << " (resolution scale " << pRenderer->GetResolutionScale() << ")";
+			std::cout << std::endl;
+
+			// times of the last frame, present runs alongside the next one
+			const Profiler& profiler = Profiler::GetInstance();
+			if (profiler.IsEnabled())
+			{
+				for (size_t i{ size_t(ProfileStage::VertexTransform) }; i < size_t(ProfileStage::Count); ++i)
+					std::cout << "  " << Profiler::GetStageName(ProfileStage(i)) << ": " << profiler.GetStageTime(ProfileStage(i)) << "ms";
+				std::cout << "  (frame " << profiler.GetStageTime(ProfileStage::Frame) << "ms)" << std::endl;
+				PrintStatistics(pRenderer->GetStatistics());
+			}
+		}
+
+		if (nrFramesToTrace > 0 && --nrFramesToTrace == 0)
+		{
+			if (Profiler::GetInstance().EndCapture("Rasterizer_Trace.json"))
+				std::cout << "Trace written to Rasterizer_Trace.json" << std::endl;
+			else
+				std::cout << "Failed to write Rasterizer_Trace.json" << std::endl;
 		}
 
 		//Save screenshot after full render
 		if (takeScreenshot)
 		{
 			if (!pRenderer->SaveBufferToImage())
-				std::cout << "Screenshot saved!" << std::endl;
+				std::cout << "Screenshot queued!" << std::endl;
 			else
-				std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
+				std::cout << "Still writing the previous screenshot. Screenshot not saved!" << std::endl;
 			takeScreenshot = false;
 		}
 	}
@@ -108,4 +552,5 @@ int main(int argc, char* args[])
 
 	ShutDown(pWindow);
 	return 0;
+#endif
 }
\ No newline at end of file